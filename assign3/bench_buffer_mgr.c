@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+
+// Benchmark of buffer manager throughput with several client threads.
+//
+// Every thread pins a random page, reads one byte of it and unpins it
+// again. The "hit" workload keeps the working set inside the pool, so it
+// measures page-table and pin count contention; the "miss" workload uses a
+// working set four times the pool size and includes replacement and I/O.
+// The "tlb" workload pins random pages of a large memory-only pool, once
+// with normal pages and once with each kind of huge pages, to show the
+// cost of TLB misses on the frames and the frame descriptors.
+//
+// usage: bench_buffer_mgr [maxThreads [tlbPoolFrames]]
+
+#define BENCH_FILE "bench_buffer.bin"
+#define POOL_FRAMES 1024
+#define TLB_POOL_FRAMES 65536
+#define MAX_THREADS 64
+
+typedef struct BenchWorkload
+{
+  const char *name;
+  const char *pageFile; // NULL for a pool without a page file
+  int poolFrames;   // size of the buffer pool
+  int workingSet;   // number of distinct pages accessed
+  int opsPerThread; // pin/unpin pairs issued by each thread
+} BenchWorkload;
+
+typedef struct BenchWorker
+{
+  BM_BufferPool *bm;
+  const BenchWorkload *workload;
+  unsigned int seed;
+  long checksum;
+  int errors;
+} BenchWorker;
+
+static double nowSeconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *benchWorker(void *arg)
+{
+  BenchWorker *worker = (BenchWorker *)arg;
+  BM_PageHandle h;
+  int i;
+
+  for (i = 0; i < worker->workload->opsPerThread; i++)
+  {
+    int pageNum = rand_r(&worker->seed) % worker->workload->workingSet;
+    if (pinPage(worker->bm, &h, pageNum) != RC_OK)
+    {
+      worker->errors++;
+      continue;
+    }
+    // a different cache line in every page, so each pin touches new memory
+    worker->checksum += h.data[(pageNum * 64) % PAGE_SIZE];
+    unpinPage(worker->bm, &h);
+  }
+  return NULL;
+}
+
+// run one workload with the given number of threads, returns pins per
+// second and the number of frames that got huge pages
+static double runWorkload(const BenchWorkload *workload, int numThreads, BM_HugePages hugePages,
+                          long *hugePageFrames)
+{
+  BM_BufferPool bm;
+  BM_PoolOptions options = {false, false, NULL, hugePages};
+  BM_PoolStats stats;
+  BM_PageHandle h;
+  pthread_t threads[MAX_THREADS];
+  BenchWorker workers[MAX_THREADS];
+  int i, errors = 0;
+  double start, elapsed;
+
+  CHECK(initBufferPoolWithOptions(&bm, workload->pageFile, workload->poolFrames, RS_CLOCK, NULL, &options));
+  CHECK(getPoolStats(&bm, &stats));
+  *hugePageFrames = stats.hugePageFrames;
+
+  // a pool without a file would zero every page on its first pin
+  for (i = 0; workload->pageFile == NULL && i < workload->workingSet; i++)
+  {
+    CHECK(pinPage(&bm, &h, i));
+    CHECK(unpinPage(&bm, &h));
+  }
+
+  start = nowSeconds();
+  for (i = 0; i < numThreads; i++)
+  {
+    workers[i].bm = &bm;
+    workers[i].workload = workload;
+    workers[i].seed = 17 * (i + 1);
+    workers[i].checksum = 0;
+    workers[i].errors = 0;
+    pthread_create(&threads[i], NULL, benchWorker, &workers[i]);
+  }
+  for (i = 0; i < numThreads; i++)
+  {
+    pthread_join(threads[i], NULL);
+    errors += workers[i].errors;
+  }
+  elapsed = nowSeconds() - start;
+
+  CHECK(shutdownBufferPool(&bm));
+  if (errors > 0)
+    printf("  (%i pins failed)\n", errors);
+
+  return (double)workload->opsPerThread * numThreads / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+  const BenchWorkload workloads[] = {
+      {"hit", BENCH_FILE, POOL_FRAMES, POOL_FRAMES / 2, 400000},
+      {"miss", BENCH_FILE, POOL_FRAMES, POOL_FRAMES * 4, 40000}};
+  const int threadCounts[] = {1, 2, 4, 8, 16};
+  const BM_HugePages hugeModes[] = {BM_HUGE_PAGES_NONE, BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT};
+  const char *hugeNames[] = {"none", "transparent", "explicit"};
+  int maxThreads = (argc > 1) ? atoi(argv[1]) : 16;
+  int tlbFrames = (argc > 2) ? atoi(argv[2]) : TLB_POOL_FRAMES;
+  BenchWorkload tlb = {"tlb", NULL, tlbFrames, tlbFrames, 2000000};
+  long hugePageFrames;
+  int w, t, m;
+
+  initStorageManager();
+  CHECK(createPageFile(BENCH_FILE));
+  {
+    // size the file up front so the benchmark does not measure file growth
+    SM_FileHandle fh;
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(POOL_FRAMES * 4, &fh));
+    CHECK(closePageFile(&fh));
+  }
+
+  printf("%-6s %8s %14s %8s\n", "load", "threads", "pins/sec", "speedup");
+  for (w = 0; w < 2; w++)
+  {
+    double base = 0;
+    for (t = 0; t < 5 && threadCounts[t] <= maxThreads && threadCounts[t] <= MAX_THREADS; t++)
+    {
+      double rate = runWorkload(&workloads[w], threadCounts[t], BM_HUGE_PAGES_NONE, &hugePageFrames);
+      if (t == 0)
+        base = rate;
+      printf("%-6s %8i %14.0f %7.2fx\n", workloads[w].name, threadCounts[t], rate, rate / base);
+    }
+  }
+
+  // random pins over a large pool, with and without huge pages
+  printf("\n%-6s %8s %12s %14s %8s %12s\n", "load", "threads", "huge pages", "pins/sec", "speedup", "huge frames");
+  for (t = 0; t < 2; t++)
+  {
+    int numThreads = (t == 0) ? 1 : ((maxThreads < MAX_THREADS) ? maxThreads : MAX_THREADS);
+    double base = 0;
+    for (m = 0; m < 3; m++)
+    {
+      double rate = runWorkload(&tlb, numThreads, hugeModes[m], &hugePageFrames);
+      if (m == 0)
+        base = rate;
+      printf("%-6s %8i %12s %14.0f %7.2fx %12li\n", tlb.name, numThreads, hugeNames[m], rate,
+             rate / base, hugePageFrames);
+    }
+  }
+
+  CHECK(destroyPageFile(BENCH_FILE));
+  return 0;
+}
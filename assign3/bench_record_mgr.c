@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+
+// Benchmark of record manager throughput on a heap file.
+//
+// Inserts records into a fresh table one at a time, reads every one of
+// them back by RID in random order and scans the whole table without a
+// condition, once copying every record with next and once reading them in
+// place with nextView. A second table is then filled with insertRecords in batches
+// of BATCH_SIZE, and a third with bulkLoadTable from the same rows written
+// to a temporary file. With a pool smaller than the table the gets and the
+// scan include page replacement and I/O; by default the pool holds both
+// tables.
+//
+// usage: bench_record_mgr [numRecords [poolFrames]]
+
+#define BENCH_TABLE "bench_table.bin"
+#define BENCH_BATCH_TABLE "bench_batch.bin"
+#define BENCH_BULK_TABLE "bench_bulk.bin"
+#define BATCH_SIZE 256
+#define NUM_RECORDS 100000
+#define STRING_LENGTH 16
+
+static double nowSeconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Schema *benchSchema(void)
+{
+  char *names[] = {"a", "b", "c"};
+  DataType dt[] = {DT_INT, DT_STRING, DT_INT};
+  int sizes[] = {0, STRING_LENGTH, 0};
+  int keys[] = {0};
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+static void fillRecord(Record *record, Schema *schema, int i)
+{
+  char buf[STRING_LENGTH + 1];
+  Value value;
+
+  value.dt = DT_INT;
+  value.v.intV = i;
+  CHECK(setAttr(record, schema, 0, &value));
+  snprintf(buf, sizeof(buf), "row-%i", i);
+  value.dt = DT_STRING;
+  value.v.stringV = buf;
+  CHECK(setAttr(record, schema, 1, &value));
+  value.dt = DT_INT;
+  value.v.intV = i % 100;
+  CHECK(setAttr(record, schema, 2, &value));
+}
+
+static void report(const char *name, long ops, double seconds)
+{
+  printf("%-8s %10li %10.3f %14.0f\n", name, ops, seconds, ops / seconds);
+}
+
+int main(int argc, char *argv[])
+{
+  int numRecords = (argc > 1) ? atoi(argv[1]) : NUM_RECORDS;
+  int poolFrames = (argc > 2) ? atoi(argv[2]) : 0;
+  RM_TableData table, batchTable, bulkTable;
+  RM_ScanHandle scan;
+  RecordView view;
+  Schema *schema = benchSchema();
+  Record *record;
+  Record *batch[BATCH_SIZE];
+  RID *rids;
+  double start;
+  long scanned = 0, viewed = 0, checksum = 0;
+  int i, j;
+
+  if (numRecords <= 0 || poolFrames < 0)
+  {
+    fprintf(stderr, "usage: %s [numRecords [poolFrames]]\n", argv[0]);
+    return 1;
+  }
+  // by default the pool is large enough for both tables
+  if (poolFrames == 0)
+    poolFrames = 2 * (numRecords / (PAGE_SIZE / (getRecordSize(schema) + 4)) + 16);
+
+  rids = (RID *)malloc(sizeof(RID) * numRecords);
+  CHECK(initRecordManager(&poolFrames));
+  CHECK(createTable(BENCH_TABLE, schema));
+  CHECK(openTable(&table, BENCH_TABLE));
+  CHECK(createRecord(&record, schema));
+
+  start = nowSeconds();
+  for (i = 0; i < numRecords; i++)
+  {
+    fillRecord(record, schema, i);
+    CHECK(insertRecord(&table, record));
+    rids[i] = record->id;
+  }
+  double insertSeconds = nowSeconds() - start;
+
+  // visit the RIDs in random order
+  srand(42);
+  for (i = numRecords - 1; i > 0; i--)
+  {
+    int j = rand() % (i + 1);
+    RID tmp = rids[i];
+    rids[i] = rids[j];
+    rids[j] = tmp;
+  }
+  start = nowSeconds();
+  for (i = 0; i < numRecords; i++)
+  {
+    CHECK(getRecord(&table, rids[i], record));
+    checksum += record->data[0];
+  }
+  double getSeconds = nowSeconds() - start;
+
+  start = nowSeconds();
+  CHECK(startScan(&table, &scan, NULL));
+  while (next(&scan, record) == RC_OK)
+  {
+    scanned++;
+    checksum += record->data[0];
+  }
+  CHECK(closeScan(&scan));
+  double scanSeconds = nowSeconds() - start;
+
+  start = nowSeconds();
+  CHECK(startScan(&table, &scan, NULL));
+  while (nextView(&scan, &view) == RC_OK)
+  {
+    viewed++;
+    checksum += view.record.data[0];
+  }
+  CHECK(closeScan(&scan));
+  double viewSeconds = nowSeconds() - start;
+
+  CHECK(createTable(BENCH_BATCH_TABLE, schema));
+  CHECK(openTable(&batchTable, BENCH_BATCH_TABLE));
+  for (j = 0; j < BATCH_SIZE; j++)
+    CHECK(createRecord(&batch[j], schema));
+  start = nowSeconds();
+  for (i = 0; i < numRecords; i += BATCH_SIZE)
+  {
+    int n = (numRecords - i < BATCH_SIZE) ? numRecords - i : BATCH_SIZE;
+    for (j = 0; j < n; j++)
+      fillRecord(batch[j], schema, i + j);
+    CHECK(insertRecords(&batchTable, batch, n));
+  }
+  double batchSeconds = nowSeconds() - start;
+
+  FILE *input = tmpfile();
+  for (i = 0; i < numRecords; i++)
+    fprintf(input, "%i,row-%i,%i\n", i, i, i % 100);
+  rewind(input);
+  start = nowSeconds();
+  CHECK(bulkLoadTable(BENCH_BULK_TABLE, schema, input, NULL));
+  double bulkSeconds = nowSeconds() - start;
+  fclose(input);
+  CHECK(openTable(&bulkTable, BENCH_BULK_TABLE));
+
+  printf("%i records of %i bytes, %i pool frames, checksum %li\n", numRecords,
+         getRecordSize(schema), poolFrames, checksum);
+  printf("%-8s %10s %10s %14s\n", "op", "records", "seconds", "records/sec");
+  report("insert", numRecords, insertSeconds);
+  report("get", numRecords, getSeconds);
+  report("scan", scanned, scanSeconds);
+  report("view", viewed, viewSeconds);
+  report("batch", getNumTuples(&batchTable), batchSeconds);
+  report("bulk", getNumTuples(&bulkTable), bulkSeconds);
+
+  for (j = 0; j < BATCH_SIZE; j++)
+    CHECK(freeRecord(batch[j]));
+  CHECK(freeRecord(record));
+  CHECK(closeTable(&bulkTable));
+  CHECK(deleteTable(BENCH_BULK_TABLE));
+  CHECK(closeTable(&batchTable));
+  CHECK(deleteTable(BENCH_BATCH_TABLE));
+  CHECK(closeTable(&table));
+  CHECK(deleteTable(BENCH_TABLE));
+  CHECK(shutdownRecordManager());
+  CHECK(freeSchema(schema));
+  free(rids);
+  return (scanned == numRecords && viewed == numRecords) ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+// Offline simulator for the buffer replacement strategies.
+//
+// Replays a page access trace recorded with startPageTrace against every
+// implemented replacement strategy at a range of pool sizes and prints the
+// hit ratio of each combination. The replay runs on pools without a page
+// file, so it does no disk I/O and every policy sees exactly the same
+// sequence of pins, unpins and markDirty calls.
+//
+// usage: bm_sim [-c] trace [minPages maxPages [step]]
+//   -c        print CSV rows instead of the table, for plotting
+//   minPages  smallest pool size, maxPages the largest one; by default the
+//             size doubles from the peak number of pinned pages up to the
+//             number of distinct pages in the trace
+
+#define SIM_MAX_FILES 64
+#define SIM_MAX_SIZES 64
+
+typedef struct SimStrategy
+{
+  const char *name;
+  ReplacementStrategy strategy;
+} SimStrategy;
+
+// LRU-K has no victim selection in the buffer manager yet
+static const SimStrategy strategies[] = {
+    {"FIFO", RS_FIFO},
+    {"LRU", RS_LRU},
+    {"CLOCK", RS_CLOCK},
+    {"LFU", RS_LFU}};
+#define NUM_STRATEGIES ((int)(sizeof(strategies) / sizeof(strategies[0])))
+
+typedef struct SimTrace
+{
+  BM_TraceRecord *records;
+  long numRecords;
+  long numPins;
+  int numDistinct;   // distinct (file, page) pairs pinned
+  int peakPinned;    // most pages pinned at the same time
+  int numFiles;
+  unsigned short files[SIM_MAX_FILES];
+} SimTrace;
+
+typedef struct SimResult
+{
+  long hits;
+  long misses;
+  long writes;
+  long failedPins; // pins that found every frame pinned
+} SimResult;
+
+static int compareKeys(const void *a, const void *b)
+{
+  long x = *(const long *)a, y = *(const long *)b;
+  return (x > y) - (x < y);
+}
+
+static int fileIndex(SimTrace *trace, unsigned short file)
+{
+  int i;
+  for (i = 0; i < trace->numFiles; i++)
+    if (trace->files[i] == file)
+      return i;
+  return -1;
+}
+
+// read a whole trace file and work out its working set
+static int loadTrace(const char *name, SimTrace *trace)
+{
+  char magic[BM_TRACE_MAGIC_LEN];
+  long capacity = 1 << 16, i, numKeys = 0, pinned = 0;
+  long *keys;
+  FILE *file = fopen(name, "rb");
+
+  memset(trace, 0, sizeof(SimTrace));
+  if (file == NULL)
+  {
+    fprintf(stderr, "bm_sim: cannot open %s\n", name);
+    return -1;
+  }
+  if (fread(magic, 1, BM_TRACE_MAGIC_LEN, file) != BM_TRACE_MAGIC_LEN ||
+      memcmp(magic, BM_TRACE_MAGIC, BM_TRACE_MAGIC_LEN) != 0)
+  {
+    fprintf(stderr, "bm_sim: %s is not a page access trace\n", name);
+    fclose(file);
+    return -1;
+  }
+
+  trace->records = (BM_TraceRecord *)malloc(sizeof(BM_TraceRecord) * capacity);
+  while (trace->records != NULL)
+  {
+    trace->numRecords += fread(trace->records + trace->numRecords, sizeof(BM_TraceRecord),
+                               capacity - trace->numRecords, file);
+    if (trace->numRecords < capacity)
+      break;
+    capacity *= 2;
+    trace->records = (BM_TraceRecord *)realloc(trace->records, sizeof(BM_TraceRecord) * capacity);
+  }
+  fclose(file);
+  if (trace->records == NULL)
+  {
+    fprintf(stderr, "bm_sim: out of memory\n");
+    return -1;
+  }
+
+  // count distinct pages by sorting the keys of all pins
+  keys = (long *)malloc(sizeof(long) * (trace->numRecords + 1));
+  for (i = 0; i < trace->numRecords; i++)
+  {
+    BM_TraceRecord *r = &trace->records[i];
+    if (fileIndex(trace, r->file) < 0)
+    {
+      if (trace->numFiles == SIM_MAX_FILES)
+      {
+        fprintf(stderr, "bm_sim: more than %i files in the trace\n", SIM_MAX_FILES);
+        free(keys);
+        return -1;
+      }
+      trace->files[trace->numFiles++] = r->file;
+    }
+    if (r->op == BM_TRACE_PIN)
+    {
+      keys[numKeys++] = ((long)r->file << 32) | (unsigned int)r->pageNum;
+      trace->numPins++;
+      if (++pinned > trace->peakPinned)
+        trace->peakPinned = (int)pinned;
+    }
+    else if (r->op == BM_TRACE_UNPIN && pinned > 0)
+    {
+      pinned--;
+    }
+  }
+  qsort(keys, numKeys, sizeof(long), compareKeys);
+  for (i = 0; i < numKeys; i++)
+    if (i == 0 || keys[i] != keys[i - 1])
+      trace->numDistinct++;
+  free(keys);
+
+  return 0;
+}
+
+// replay the trace on a fresh pool without page files
+static void replay(const SimTrace *trace, ReplacementStrategy strategy, int numPages, SimResult *result)
+{
+  BM_BufferPool pool;
+  BM_BufferPool handles[SIM_MAX_FILES];
+  BM_PoolStats stats;
+  BM_PageHandle h;
+  long i;
+  int f, j;
+
+  memset(result, 0, sizeof(SimResult));
+  CHECK(initSharedBufferPool(&pool, numPages, strategy, NULL));
+  for (f = 0; f < trace->numFiles; f++)
+    CHECK(attachBufferPool(&handles[f], &pool, NULL));
+
+  for (i = 0; i < trace->numRecords; i++)
+  {
+    const BM_TraceRecord *r = &trace->records[i];
+    BM_BufferPool *bm = &handles[fileIndex((SimTrace *)trace, r->file)];
+    h.pageNum = r->pageNum;
+    switch (r->op)
+    {
+    case BM_TRACE_PIN:
+      if (pinPage(bm, &h, r->pageNum) != RC_OK)
+        result->failedPins++;
+      break;
+    case BM_TRACE_UNPIN:
+      unpinPage(bm, &h);
+      break;
+    case BM_TRACE_DIRTY:
+      markDirty(bm, &h);
+      break;
+    }
+  }
+
+  CHECK(getPoolStats(&pool, &stats));
+  result->hits = stats.hits;
+  result->misses = stats.misses;
+  result->writes = stats.writes;
+
+  // the trace may end while pages are still pinned
+  for (f = 0; f < trace->numFiles; f++)
+  {
+    PageNumber *pages = getFrameContents(&handles[f]);
+    int *fixCounts = getFixCounts(&handles[f]);
+    for (j = 0; j < handles[f].numPages; j++)
+    {
+      h.pageNum = pages[j];
+      while (pages[j] != NO_PAGE && fixCounts[j]-- > 0)
+        unpinPage(&handles[f], &h);
+    }
+    free(pages);
+    free(fixCounts);
+    CHECK(shutdownBufferPool(&handles[f]));
+  }
+  CHECK(shutdownBufferPool(&pool));
+}
+
+int main(int argc, char *argv[])
+{
+  SimTrace trace;
+  SimResult result;
+  int sizes[SIM_MAX_SIZES];
+  int numSizes = 0, csv = 0, arg = 1, s, i;
+
+  if (arg < argc && strcmp(argv[arg], "-c") == 0)
+  {
+    csv = 1;
+    arg++;
+  }
+  if (arg >= argc)
+  {
+    fprintf(stderr, "usage: %s [-c] trace [minPages maxPages [step]]\n", argv[0]);
+    return 1;
+  }
+  if (loadTrace(argv[arg], &trace) != 0)
+    return 1;
+  if (trace.numPins == 0)
+  {
+    fprintf(stderr, "bm_sim: the trace has no pins\n");
+    return 1;
+  }
+
+  if (arg + 2 < argc)
+  {
+    int minPages = atoi(argv[arg + 1]), maxPages = atoi(argv[arg + 2]);
+    int step = (arg + 3 < argc) ? atoi(argv[arg + 3]) : 1;
+    if (minPages <= 0 || maxPages < minPages || step <= 0)
+    {
+      fprintf(stderr, "bm_sim: bad pool size range\n");
+      return 1;
+    }
+    for (s = minPages; s <= maxPages && numSizes < SIM_MAX_SIZES; s += step)
+      sizes[numSizes++] = s;
+  }
+  else
+  {
+    for (s = (trace.peakPinned > 0) ? trace.peakPinned : 1;
+         s < trace.numDistinct && numSizes < SIM_MAX_SIZES - 1; s *= 2)
+      sizes[numSizes++] = s;
+    sizes[numSizes++] = trace.numDistinct;
+  }
+
+  if (csv)
+  {
+    printf("strategy,pages,hits,misses,hit_ratio,writes,failed_pins\n");
+  }
+  else
+  {
+    printf("%ld records, %ld pins of %i distinct pages in %i file(s), "
+           "at most %i pinned, %.3f s\n",
+           trace.numRecords, trace.numPins, trace.numDistinct, trace.numFiles,
+           trace.peakPinned, trace.records[trace.numRecords - 1].timestamp / 1e9);
+    printf("hit ratio (%%) by pool size\n%8s", "pages");
+    for (i = 0; i < NUM_STRATEGIES; i++)
+      printf(" %8s", strategies[i].name);
+    printf("\n");
+  }
+
+  for (s = 0; s < numSizes; s++)
+  {
+    if (!csv)
+      printf("%8i", sizes[s]);
+    for (i = 0; i < NUM_STRATEGIES; i++)
+    {
+      replay(&trace, strategies[i].strategy, sizes[s], &result);
+      double ratio = (result.hits + result.misses > 0)
+                         ? (double)result.hits / (result.hits + result.misses)
+                         : 0;
+      if (csv)
+        printf("%s,%i,%ld,%ld,%.4f,%ld,%ld\n", strategies[i].name, sizes[s],
+               result.hits, result.misses, ratio, result.writes, result.failedPins);
+      else if (result.failedPins > 0)
+        printf(" %8s", "pinned"); // pool smaller than the pinned working set
+      else
+        printf(" %8.2f", 100 * ratio);
+    }
+    if (!csv)
+      printf("\n");
+  }
+
+  free(trace.records);
+  return 0;
+}
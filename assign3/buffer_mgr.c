@@ -1,145 +1,672 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
-#include <string.h>
+
+// Number of independently latched page-table partitions. Pages hash to a
+// partition, so pins of different pages rarely contend on the same latch.
+#ifndef BM_PAGE_TABLE_PARTITIONS
+#define BM_PAGE_TABLE_PARTITIONS 16
+#endif
+
+// Maximum number of page files registered with one pool at the same time
+#ifndef BM_MAX_FILES
+#define BM_MAX_FILES 64
+#endif
+
+// Frames are allocated in extents of 2^BM_EXTENT_SHIFT frames, so the pool
+// can grow without moving frames that other threads are using. The default
+// makes the arena of an extent exactly one 2 MB huge page.
+#ifndef BM_EXTENT_SHIFT
+#define BM_EXTENT_SHIFT 9
+#endif
+#define BM_EXTENT_FRAMES (1 << BM_EXTENT_SHIFT)
+#define BM_ARENA_SIZE ((size_t)BM_EXTENT_FRAMES * PAGE_SIZE)
+
+// Size of the huge pages arenas are backed by on request; arenas that are
+// not a multiple of it always use normal pages
+#ifndef BM_HUGE_PAGE_SIZE
+#define BM_HUGE_PAGE_SIZE ((size_t)2 << 20)
+#endif
+
+// Upper bound on the number of extents, and so on the size of a pool
+#ifndef BM_MAX_EXTENTS
+#define BM_MAX_EXTENTS 4096
+#endif
+
+// Marks the end of a page-table hash chain
+#define NO_FRAME -1
+
+// File id of a handle that is not bound to a page file
+#define NO_FILE -1
+
+// Trace records buffered in memory before they are written to the trace file
+#ifndef BM_TRACE_BUFFER_RECORDS
+#define BM_TRACE_BUFFER_RECORDS 4096
+#endif
+
+// Largest run of consecutive pages loaded with one read when warming up
+#ifndef BM_WARM_READ_PAGES
+#define BM_WARM_READ_PAGES 64
+#endif
+
+// Header of a warm-up file, followed by the page count and the page numbers
+#define BM_WARM_MAGIC "BMWARM01"
+#define BM_WARM_MAGIC_LEN 8
+
+// Optimistic reads of a changing page retried before falling back to a pin
+#ifndef BM_OPTIMISTIC_RETRIES
+#define BM_OPTIMISTIC_RETRIES 8
+#endif
+
+// Capacity of the queue of pages waiting to be prefetched
+#ifndef BM_PREFETCH_QUEUE_SIZE
+#define BM_PREFETCH_QUEUE_SIZE 256
+#endif
+
+// Atomic helpers for fields that are read and written outside any latch
+#define ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define ATOMIC_INC(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#define ATOMIC_DEC(ptr) __atomic_sub_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#define ATOMIC_CAS(ptr, expected, desired)                              \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), false,    \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define COUNTER_INC(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#define COUNTER_ADD(ptr, n) __atomic_add_fetch((ptr), (n), __ATOMIC_RELAXED)
+#define RELAXED_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define RELAXED_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
+#define ATOMIC_OR(ptr, bits) __atomic_fetch_or((ptr), (bits), __ATOMIC_ACQ_REL)
+#define ATOMIC_AND(ptr, bits) __atomic_fetch_and((ptr), (bits), __ATOMIC_ACQ_REL)
+
+// Content latch word of a frame: the number of shared holders in the low
+// bits and the flags below
+#define LATCH_EXCLUSIVE 0x40000000u      // Held by one exclusive holder
+#define LATCH_WRITER_WAITING 0x20000000u // An exclusive request waits, new shared requests wait too
+#define LATCH_SLEEPERS 0x10000000u       // Somebody sleeps on the partition's latchFree
+#define LATCH_SHARED_MASK 0x0FFFFFFFu
+
+// Counts an event for a file and for the whole pool
+#define COUNT_EVENT(metadata, fileId, field)                        \
+    do                                                              \
+    {                                                               \
+        COUNTER_INC(&fileFor((metadata), (fileId))->stats.field);   \
+        COUNTER_INC(&(metadata)->stats.field);                      \
+    } while (0)
 
 // Structure representing a page frame in the buffer pool
-// Uses doubly linked list for easy insertion/deletion
-typedef struct DLNode
-{
-    SM_PageHandle data;  // Actual page data in memory
-    PageNumber pageNum;  // Page number in the file
-    bool isDirty;        // True if page was modified
-    int pinCount;        // Number of clients using this page
-    int accessCount;     // Counter for LFU strategy
+// Frames live in extents; the page table chains them by index
+typedef struct Frame
+{
+    SM_PageHandle data;  // Page-sized slot inside the arena of the frame's extent
+    int fileId;          // File the page belongs to, valid while pageNum is set
+    PageNumber pageNum;  // Page number in the file, NO_PAGE if the frame is empty
+    bool isDirty;        // True if page was modified (atomic)
+    bool ioInProgress;   // True while the page is read or written back (partition latch)
+    int pinCount;        // Number of clients using this page (atomic)
+    int accessCount;     // Counter for LFU strategy, reference bit for CLOCK
     int lastAccessed;    // Timestamp for LRU strategy
-    int *accessHistory;  // History array for LRU-K
-    int historySize;     // Size of history array
-    struct DLNode *next; // Next node in the list
-    struct DLNode *prev; // Previous node in the list
-} DLNode;
+    int hashNext;        // Next frame in the same page-table bucket
+    bool retired;        // True while the frame is given up by a shrink (atomic)
+    unsigned int latch;  // Content latch word, see LATCH_EXCLUSIVE (atomic)
+    unsigned int version; // Odd while the contents change, bumped by every change (atomic)
+    int hint;            // BM_PageHint of the page, reset when it is evicted (partition latch)
+    long dirtiedAt;      // Monotonic time in ns the page was first dirtied since its last write
+} Frame;
+
+// One slice of the page table, guarded by its own latch
+typedef struct PageTablePartition
+{
+    pthread_mutex_t latch; // Guards the buckets and the ioInProgress flag of mapped frames
+    pthread_cond_t ioDone; // Broadcast whenever an in-flight read or write completes
+    pthread_cond_t latchFree; // Broadcast when a content latch with sleepers is released
+    int *buckets;          // Heads of the hash chains, NO_FRAME if empty
+    int numBuckets;        // Number of hash chains in this partition
+} __attribute__((aligned(64))) PageTablePartition;
+
+// Event counters, kept per file and for the whole pool (atomic)
+typedef struct PoolCounters
+{
+    long readCount;      // Number of disk reads performed
+    long writeCount;     // Number of disk writes performed
+    long fgWriteCount;   // Dirty victims written by pinPage itself
+    long bgWriteCount;   // Pages cleaned by the background writer
+    long hits;           // Pins of resident pages
+    long misses;         // Pins that had to read the page
+    long cleanEvictions; // Victims dropped without a write
+    long dirtyEvictions; // Victims written back before reuse
+    long forcedWrites;   // Pages written by forcePage
+    long checkpointWrites; // Pages written by checkpoints
+    long pinWaits;       // Pins that waited for I/O in flight on the page
+    long readLatency[BM_LATENCY_BUCKETS];  // Reads by log2 of their microseconds
+    long writeLatency[BM_LATENCY_BUCKETS]; // Writes by log2 of their microseconds
+} PoolCounters;
+
+// A page file registered with the pool
+typedef struct PoolFile
+{
+    pthread_mutex_t latch;    // Serializes use of the file handle
+    int fileId;               // Id of the registration, NO_FILE if the slot is free
+    int generation;           // Bumped on every registration, so ids are never reused
+    int refCount;             // Handles attached to the file
+    char *fileName;           // Copy of the page file name, NULL for a memory-only file
+    bool inMemory;            // No page file behind it: reads give zeroed pages, writes are dropped
+    SM_FileHandle fileHandle; // Page file, open while the file is registered
+    PoolCounters stats;       // Events on this file
+} PoolFile;
+
+// A page waiting in the prefetch queue
+typedef struct PageRequest
+{
+    int fileId;
+    PageNumber pageNum;
+} PageRequest;
+
+// An entry of a checkpoint's dirty-page table
+typedef struct DirtyPage
+{
+    int fileId;
+    PageNumber pageNum;
+    long dirtiedAt; // First-dirtied time of the page when the checkpoint started
+} DirtyPage;
 
 // Metadata structure maintaining buffer pool state and statistics
 typedef struct BufferPoolMetadata
 {
-    DLNode *head;      // First page frame in the pool
-    DLNode *tail;      // Last page frame in the pool
-    DLNode *fifoHead;  // Tracks oldest page for FIFO
-    int numFramesUsed; // Current number of frames in use
-    int totalFrames;   // Total capacity of frames
-    int readCount;     // Number of disk reads performed
-    int writeCount;    // Number of disk writes performed
-    int clockHand;     // Current position for CLOCK algorithm
-    int globalTimer;   // Global counter for timestamps
+    Frame *extents[BM_MAX_EXTENTS]; // Frame descriptors, never moved once allocated
+    char *arenas[BM_MAX_EXTENTS];   // Mapped memory holding the data of each extent's frames
+    unsigned char arenaPages[BM_MAX_EXTENTS]; // BM_HugePages each arena was actually mapped with
+    BM_HugePages hugePages;  // Huge pages requested for new arenas
+    int numExtents;          // Extents allocated so far (atomic, written under resizeLatch)
+    int numFramesUsed;       // Frames handed out so far, in frame order
+    int totalFrames;         // Frames in use or retired (atomic, written under replLatch)
+    int numRetired;          // Frames given up by shrinking the pool (resizeLatch)
+    pthread_mutex_t resizeLatch; // Serializes resizes of the pool
+    ReplacementStrategy strategy; // One policy for the pages of every file
+    PageTablePartition partitions[BM_PAGE_TABLE_PARTITIONS];
+    pthread_mutex_t replLatch; // Guards victim selection and the strategy state below
+    int fifoHand;            // Next frame to consider for FIFO
+    int clockHand;           // Current position for CLOCK algorithm
+    int globalTimer;         // Global counter for timestamps (atomic)
+    int numHotFrames;        // Frames holding a page hinted BM_HINT_HOT (atomic)
+    int numColdFrames;       // Frames holding a page hinted BM_HINT_COLD (atomic)
+    pthread_mutex_t filesLatch; // Guards registration of files and handles
+    PoolFile files[BM_MAX_FILES]; // Registered files, a file id maps to slot id % BM_MAX_FILES
+    int numAttached;         // Handles attached with attachBufferPool
+    PoolCounters stats;      // Events on all files together
+    pthread_mutex_t writerLatch; // Guards the background writer state below
+    pthread_cond_t writerWake;   // Signalled to stop the background writer
+    pthread_t writerThread;      // Background writer, if running
+    bool writerRunning;          // True while the background writer is active
+    bool writerStop;             // Asks the background writer to exit
+    int writerInterval;          // Milliseconds between two writer rounds
+    int writerMaxPages;          // Pages written per round at most
+    pthread_mutex_t prefetchLatch; // Guards the prefetch queue and thread state
+    pthread_cond_t prefetchWake;   // Signalled when requests are queued or on stop
+    pthread_t prefetchThread;      // Loads queued pages, started on first use
+    bool prefetchRunning;          // True while the prefetch thread is active
+    bool prefetchStop;             // Asks the prefetch thread to exit
+    PageRequest prefetchQueue[BM_PREFETCH_QUEUE_SIZE]; // Ring of requested pages
+    int prefetchHead;              // Oldest queued request
+    int prefetchCount;             // Number of queued requests
+    pthread_mutex_t traceLatch;    // Guards the trace state below
+    bool tracing;                  // True while page accesses are traced (atomic)
+    bool traceFailed;              // A write to the trace file failed
+    FILE *traceFile;               // Trace being recorded
+    BM_TraceRecord *traceBuffer;   // Records not yet written to the trace file
+    int traceCount;                // Number of records in traceBuffer
+    struct timespec traceStart;    // Time the trace was started
+    pthread_mutex_t freeLatch;     // Guards the free-frame list and evictor state below
+    pthread_cond_t evictorWake;    // Signalled when the list falls below the low watermark or on stop
+    pthread_t evictorThread;       // Refills the free-frame list, if running
+    bool evictorRunning;           // True while the evictor is active
+    bool evictorStop;              // Asks the evictor to exit
+    int lowWatermark;              // The evictor refills the list below this many frames
+    int highWatermark;             // and then evicts up to this many
+    int *freeFrames;               // Empty frames, each pinned once by the list
+    int numFree;                   // Number of frames in freeFrames (atomic, written under freeLatch)
+    pthread_mutex_t checkpointLatch; // Guards the checkpoint state below
+    pthread_cond_t checkpointWake;   // Signalled to stop a paced checkpoint
+    pthread_t checkpointThread;      // Writes the pages of the running checkpoint
+    bool checkpointRunning;          // True from startCheckpoint until the thread is joined
+    bool checkpointStop;             // Asks the checkpoint thread to give up
+    int checkpointRate;              // Pages written per second at most, 0 for no limit
+    DirtyPage *checkpointPages;      // Dirty-page table of the running checkpoint, oldest first
+    int checkpointTotal;             // Entries in checkpointPages
+    int checkpointDone;              // Entries visited so far (atomic)
+    RC checkpointResult;             // First write error of the running checkpoint
+    long checkpointStart;            // Monotonic time in ns the checkpoint started
+    long numCheckpoints;             // Checkpoints completed (atomic)
+    long lastCheckpointMicros;       // Duration of the last completed checkpoint (atomic)
 } BufferPoolMetadata;
 
+// What BM_BufferPool.mgmtData points to: a view of a possibly shared pool
+typedef struct PoolHandle
+{
+    BufferPoolMetadata *pool; // Pool the handle works on
+    int fileId;               // File accessed through the handle, NO_FILE for a bare shared pool
+    bool ownsPool;            // True if shutting the handle down destroys the pool
+    char *warmFile;           // Warm-up file written on shutdown, NULL for none
+} PoolHandle;
+
+// prototypes
+static void stopPrefetcher(BufferPoolMetadata *metadata);
+static void stopCheckpoint(BufferPoolMetadata *metadata);
+static void destroyPool(BufferPoolMetadata *metadata);
+static char *warmFileName(BM_BufferPool *const bm, const char *warmFile);
+
+/**
+ * Returns the descriptor of a frame
+ */
+static Frame *frameAt(BufferPoolMetadata *metadata, int index)
+{
+    return &metadata->extents[index >> BM_EXTENT_SHIFT][index & (BM_EXTENT_FRAMES - 1)];
+}
+
+/**
+ * Hashes a (file, page) pair. Consecutive pages of a file land in
+ * consecutive partitions; the file id gives every file its own offset.
+ */
+static unsigned pageHash(int fileId, PageNumber pageNum)
+{
+    return (unsigned)pageNum + (unsigned)fileId * 0x9E3779B1u;
+}
+
 /**
- * Creates a new DLNode with given data and page number
+ * Returns the page-table partition responsible for a page
  */
-static DLNode *createNode(SM_PageHandle data, PageNumber pageNum)
+static PageTablePartition *partitionFor(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum)
 {
-    // Allocate memory for new node
-    DLNode *newNode = (DLNode *)malloc(sizeof(DLNode));
+    return &metadata->partitions[pageHash(fileId, pageNum) % BM_PAGE_TABLE_PARTITIONS];
+}
 
-    // Initialize node fields
-    newNode->data = data;
-    newNode->pageNum = pageNum;
-    newNode->isDirty = false;
-    newNode->pinCount = 1;     // New pages start with pin count 1
-    newNode->accessCount = 1;  // Initialize access count
-    newNode->lastAccessed = 0; // Will be set by caller
-    newNode->next = NULL;
-    newNode->prev = NULL;
+/**
+ * Returns the head of the hash chain for a page within its partition
+ */
+static int *bucketFor(PageTablePartition *part, int fileId, PageNumber pageNum)
+{
+    return &part->buckets[(pageHash(fileId, pageNum) / BM_PAGE_TABLE_PARTITIONS) % part->numBuckets];
+}
 
-    return newNode;
+/**
+ * Checks whether a frame currently holds the given page
+ */
+static bool holdsPage(Frame *frame, int fileId, PageNumber pageNum)
+{
+    return ATOMIC_LOAD(&frame->pageNum) == pageNum && ATOMIC_LOAD(&frame->fileId) == fileId;
 }
 
 /**
- * Searches for a page in the buffer pool
+ * Searches the page table for a page; caller holds the partition latch
  */
-static DLNode *findPage(BufferPoolMetadata *metadata, PageNumber pageNum)
+static int findFrame(BufferPoolMetadata *metadata, PageTablePartition *part,
+                     int fileId, PageNumber pageNum)
 {
-    // Start from head of list
-    DLNode *current = metadata->head;
+    int index = *bucketFor(part, fileId, pageNum);
 
-    // Traverse until page is found or end of list
-    while (current != NULL)
+    // Walk the chain until the page is found or the chain ends
+    while (index != NO_FRAME)
     {
-        if (current->pageNum == pageNum)
-            return current;
-        current = current->next;
+        if (holdsPage(frameAt(metadata, index), fileId, pageNum))
+            return index;
+        index = frameAt(metadata, index)->hashNext;
     }
-    return NULL;
+    return NO_FRAME;
 }
 
 /**
- * Implements FIFO page replacement strategy
+ * Adds a frame to the page table; caller holds the partition latch
  */
-static DLNode *replaceFIFO(BufferPoolMetadata *metadata)
+static void insertFrame(BufferPoolMetadata *metadata, PageTablePartition *part, int index)
 {
-    // If FIFO queue is empty, initialize to head
-    if (metadata->fifoHead == NULL)
+    Frame *frame = frameAt(metadata, index);
+    int *head = bucketFor(part, frame->fileId, frame->pageNum);
+    frame->hashNext = *head;
+    *head = index;
+}
+
+/**
+ * Removes a frame from the page table; caller holds the partition latch
+ */
+static void removeFrame(BufferPoolMetadata *metadata, PageTablePartition *part, int index)
+{
+    Frame *frame = frameAt(metadata, index);
+    int *link = bucketFor(part, frame->fileId, frame->pageNum);
+
+    // Find the link pointing at the frame and splice it out
+    while (*link != NO_FRAME)
     {
-        metadata->fifoHead = metadata->head;
+        if (*link == index)
+        {
+            *link = frame->hashNext;
+            break;
+        }
+        link = &frameAt(metadata, *link)->hashNext;
     }
+    frame->hashNext = NO_FRAME;
+}
 
-    // Start search from FIFO head
-    DLNode *current = metadata->fifoHead;
-    DLNode *startNode = current;
+/**
+ * Returns the file table slot of a file id
+ */
+static PoolFile *fileFor(BufferPoolMetadata *metadata, int fileId)
+{
+    return &metadata->files[(unsigned)fileId % BM_MAX_FILES];
+}
 
-    // Search for first unpinned page
-    do
+/**
+ * Returns the current time for latency measurements
+ */
+static struct timespec startTimer(void)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    return start;
+}
+
+/**
+ * Returns the monotonic clock in nanoseconds
+ */
+static long nowNanos(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+ * Adds the time elapsed since start to a file's and the pool's latency
+ * histogram; bucket i counts durations of 2^i up to 2^(i+1) microseconds
+ */
+static void recordLatency(BufferPoolMetadata *metadata, int fileId, bool isRead, struct timespec start)
+{
+    struct timespec end;
+    int bucket = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long micros = (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000;
+    while (bucket < BM_LATENCY_BUCKETS - 1 && (micros >> (bucket + 1)) > 0)
+        bucket++;
+
+    if (isRead)
+        COUNT_EVENT(metadata, fileId, readLatency[bucket]);
+    else
+        COUNT_EVENT(metadata, fileId, writeLatency[bucket]);
+}
+
+/**
+ * Reads a page from disk into a frame, growing the file if needed
+ */
+static RC readPageData(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, SM_PageHandle data)
+{
+    PoolFile *file = fileFor(metadata, fileId);
+    RC rc = RC_FILE_HANDLE_NOT_INIT;
+
+    pthread_mutex_lock(&file->latch);
+
+    // The file may have been detached while the request was pending
+    if (file->fileId == fileId && file->inMemory)
+    {
+        memset(data, 0, PAGE_SIZE);
+        rc = RC_OK;
+    }
+    else if (file->fileId == fileId)
     {
-        // Wrap around if we reach end of list
-        if (current == NULL)
+        struct timespec start = startTimer();
+
+        // Ensure the file has enough pages
+        rc = ensureCapacity(pageNum + 1, &file->fileHandle);
+        if (rc == RC_OK && readBlock(pageNum, &file->fileHandle, data) != RC_OK)
         {
-            current = metadata->head;
+            // If read fails, initialize with default content
+            memset(data, 0, PAGE_SIZE);
+            sprintf(data, "Page-%i", pageNum);
         }
+        if (rc == RC_OK)
+            recordLatency(metadata, fileId, true, start);
+    }
 
-        // Found an unpinned page
-        if (current->pinCount == 0)
+    pthread_mutex_unlock(&file->latch);
+
+    if (rc == RC_OK)
+        COUNT_EVENT(metadata, fileId, readCount);
+    return rc;
+}
+
+/**
+ * Writes a frame's data back to its page on disk
+ */
+static RC writePageData(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, SM_PageHandle data)
+{
+    PoolFile *file = fileFor(metadata, fileId);
+    RC rc = RC_FILE_HANDLE_NOT_INIT;
+
+    pthread_mutex_lock(&file->latch);
+    if (file->fileId == fileId && file->inMemory)
+    {
+        rc = RC_OK;
+    }
+    else if (file->fileId == fileId)
+    {
+        struct timespec start = startTimer();
+        rc = writeBlock(pageNum, &file->fileHandle, data);
+        if (rc == RC_OK)
+            recordLatency(metadata, fileId, false, start);
+    }
+    pthread_mutex_unlock(&file->latch);
+
+    if (rc == RC_OK)
+        COUNT_EVENT(metadata, fileId, writeCount);
+    return rc;
+}
+
+/**
+ * Reads a run of consecutive pages into frames with one vectored read,
+ * growing the file if needed. Falls back to page-wise reads if the
+ * vectored read fails.
+ */
+static RC readPageFrames(BufferPoolMetadata *metadata, int fileId, PageNumber start, int count,
+                         SM_PageHandle *data)
+{
+    PoolFile *file = fileFor(metadata, fileId);
+    RC rc = RC_FILE_HANDLE_NOT_INIT;
+    int i;
+
+    pthread_mutex_lock(&file->latch);
+    if (file->fileId == fileId && file->inMemory)
+    {
+        for (i = 0; i < count; i++)
+            memset(data[i], 0, PAGE_SIZE);
+        rc = RC_OK;
+    }
+    else if (file->fileId == fileId)
+    {
+        struct timespec begin = startTimer();
+
+        rc = ensureCapacity(start + count, &file->fileHandle);
+        if (rc == RC_OK && readBlocksVectored(start, count, &file->fileHandle, data) != RC_OK)
         {
-            // Update FIFO head to next node
-            metadata->fifoHead = current->next;
-            if (metadata->fifoHead == NULL)
+            for (i = 0; i < count; i++)
             {
-                metadata->fifoHead = metadata->head;
+                if (readBlock(start + i, &file->fileHandle, data[i]) != RC_OK)
+                {
+                    memset(data[i], 0, PAGE_SIZE);
+                    sprintf(data[i], "Page-%i", start + i);
+                }
             }
-            return current;
         }
+        if (rc == RC_OK)
+            recordLatency(metadata, fileId, true, begin);
+    }
+    pthread_mutex_unlock(&file->latch);
+
+    if (rc == RC_OK)
+    {
+        COUNTER_ADD(&file->stats.readCount, count);
+        COUNTER_ADD(&metadata->stats.readCount, count);
+    }
+    return rc;
+}
+
+/**
+ * Checks whether a frame may be chosen as a victim (racy, rechecked under latch)
+ */
+static bool isEvictable(Frame *frame)
+{
+    return ATOMIC_LOAD(&frame->pinCount) == 0 && !ATOMIC_LOAD(&frame->ioInProgress);
+}
+
+/**
+ * Orders frames by their hint for eviction: cold pages first, hot last
+ */
+static int hintRank(Frame *frame)
+{
+    switch (RELAXED_LOAD(&frame->hint))
+    {
+    case BM_HINT_COLD:
+        return 0;
+    case BM_HINT_HOT:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Checks whether a frame may be chosen as a victim in a pass over the
+ * frames whose hint ranks at most maxRank
+ */
+static bool isCandidate(Frame *frame, int maxRank)
+{
+    return isEvictable(frame) && hintRank(frame) <= maxRank;
+}
+
+/**
+ * Changes the hint of a frame and the pool's counts of hinted frames;
+ * caller holds the partition latch of the frame's page
+ */
+static void setFrameHint(BufferPoolMetadata *metadata, Frame *frame, int hint)
+{
+    int oldHint = RELAXED_LOAD(&frame->hint);
+
+    if (oldHint == hint)
+        return;
+    if (oldHint == BM_HINT_HOT)
+        ATOMIC_DEC(&metadata->numHotFrames);
+    else if (oldHint == BM_HINT_COLD)
+        ATOMIC_DEC(&metadata->numColdFrames);
+    if (hint == BM_HINT_HOT)
+        ATOMIC_INC(&metadata->numHotFrames);
+    else if (hint == BM_HINT_COLD)
+        ATOMIC_INC(&metadata->numColdFrames);
+    RELAXED_STORE(&frame->hint, hint);
+}
 
-        current = current->next;
+/**
+ * Bumps the version of a frame before and after its contents change, so
+ * the version is odd meanwhile and optimistic readers notice the change
+ */
+static void bumpVersion(Frame *frame)
+{
+    ATOMIC_INC(&frame->version);
+}
+
+/**
+ * Writes one frame back if it is still mapped to the page, dirty and
+ * unpinned. The frame is marked as in I/O for the duration of the write,
+ * so it is neither evicted nor pinned meanwhile. With fileId other than
+ * NO_FILE only pages of that file are written.
+ * Returns true if the page was written.
+ */
+static bool flushFrame(BufferPoolMetadata *metadata, int index, int fileId, RC *result)
+{
+    Frame *frame = frameAt(metadata, index);
+    PageNumber pageNum = ATOMIC_LOAD(&frame->pageNum);
+    int pageFile = ATOMIC_LOAD(&frame->fileId);
+
+    *result = RC_OK;
+    if (pageNum == NO_PAGE || !ATOMIC_LOAD(&frame->isDirty))
+        return false;
+    if (fileId != NO_FILE && pageFile != fileId)
+        return false;
+
+    PageTablePartition *part = partitionFor(metadata, pageFile, pageNum);
+    pthread_mutex_lock(&part->latch);
+    if (!holdsPage(frame, pageFile, pageNum) || frame->ioInProgress ||
+        ATOMIC_LOAD(&frame->pinCount) != 0 || !ATOMIC_LOAD(&frame->isDirty))
+    {
+        pthread_mutex_unlock(&part->latch);
+        return false;
+    }
+    ATOMIC_STORE(&frame->ioInProgress, true);
+    pthread_mutex_unlock(&part->latch);
+
+    ATOMIC_STORE(&frame->isDirty, false);
+    *result = writePageData(metadata, pageFile, pageNum, frame->data);
+
+    pthread_mutex_lock(&part->latch);
+    if (*result != RC_OK)
+        ATOMIC_STORE(&frame->isDirty, true);
+    ATOMIC_STORE(&frame->ioInProgress, false);
+    pthread_cond_broadcast(&part->ioDone);
+    pthread_mutex_unlock(&part->latch);
+
+    return *result == RC_OK;
+}
+
+/**
+ * Implements FIFO page replacement strategy
+ */
+static int replaceFIFO(BufferPoolMetadata *metadata, int maxRank)
+{
+    int totalFrames = metadata->totalFrames;
+    int i;
 
-        // Wrap around at end of list
-        if (current == NULL)
+    // Frames were filled in order, so walking them round-robin from the
+    // hand visits pages in the order they were loaded
+    for (i = 0; i < totalFrames; i++)
+    {
+        int index = (metadata->fifoHand + i) % totalFrames;
+
+        // Found an unpinned page
+        if (isCandidate(frameAt(metadata, index), maxRank))
         {
-            current = metadata->head;
+            metadata->fifoHand = (index + 1) % totalFrames;
+            return index;
         }
-    } while (current != startNode);
+    }
 
-    return NULL; // No unpinned pages found
+    return NO_FRAME; // No unpinned pages found
 }
 
 /**
  * Implements LRU page replacement strategy
  */
-static DLNode *replaceLRU(BufferPoolMetadata *metadata)
+static int replaceLRU(BufferPoolMetadata *metadata, int maxRank)
 {
-    DLNode *current = metadata->head;
-    DLNode *victim = NULL;
-    int minAccess = metadata->globalTimer + 1; // Initialize higher than any access time
+    int victim = NO_FRAME;
+    int minAccess = INT_MAX;
+    int totalFrames = metadata->totalFrames;
+    int i;
 
     // Find page with oldest access time
-    while (current != NULL)
+    for (i = 0; i < totalFrames; i++)
     {
+        Frame *frame = frameAt(metadata, i);
+
         // Consider only unpinned pages
-        if (current->pinCount == 0 && current->lastAccessed < minAccess)
+        int lastAccessed = RELAXED_LOAD(&frame->lastAccessed);
+        if (isCandidate(frame, maxRank) && lastAccessed < minAccess)
         {
-            minAccess = current->lastAccessed;
-            victim = current;
+            minAccess = lastAccessed;
+            victim = i;
         }
-        current = current->next;
     }
 
     return victim;
@@ -148,44 +675,31 @@ static DLNode *replaceLRU(BufferPoolMetadata *metadata)
 /**
  * Implements LFU page replacement strategy
  */
-static DLNode *replaceLFU(BufferPoolMetadata *metadata)
+static int replaceLFU(BufferPoolMetadata *metadata, int maxRank)
 {
-    DLNode *current = metadata->head;
-    DLNode *victim = NULL;
+    int victim = NO_FRAME;
     int minCount = INT_MAX;
     int oldestTimestamp = INT_MAX;
+    int totalFrames = metadata->totalFrames;
+    int i;
 
-    // Find page with lowest access count
-    while (current != NULL)
+    // Find page with lowest access count, breaking ties by age
+    for (i = 0; i < totalFrames; i++)
     {
-        if (current->pinCount == 0)
+        Frame *frame = frameAt(metadata, i);
+
+        if (!isCandidate(frame, maxRank))
+            continue;
+
+        int accessCount = RELAXED_LOAD(&frame->accessCount);
+        int lastAccessed = RELAXED_LOAD(&frame->lastAccessed);
+        if (accessCount < minCount ||
+            (accessCount == minCount && lastAccessed < oldestTimestamp))
         {
-            // First unpinned page found
-            if (victim == NULL)
-            {
-                victim = current;
-                minCount = current->accessCount;
-                oldestTimestamp = current->lastAccessed;
-            }
-            else
-            {
-                // Replace if this page has lower access count
-                if (current->accessCount < minCount)
-                {
-                    victim = current;
-                    minCount = current->accessCount;
-                    oldestTimestamp = current->lastAccessed;
-                }
-                // If equal access counts, choose older page
-                else if (current->accessCount == minCount &&
-                         current->lastAccessed < oldestTimestamp)
-                {
-                    victim = current;
-                    oldestTimestamp = current->lastAccessed;
-                }
-            }
+            victim = i;
+            minCount = accessCount;
+            oldestTimestamp = lastAccessed;
         }
-        current = current->next;
     }
 
     return victim;
@@ -194,456 +708,3113 @@ static DLNode *replaceLFU(BufferPoolMetadata *metadata)
 /**
  * Implements CLOCK page replacement strategy
  */
-static DLNode *replaceCLOCK(BufferPoolMetadata *metadata)
+static int replaceCLOCK(BufferPoolMetadata *metadata, int maxRank)
 {
-    DLNode *current = metadata->head;
-    int i;
+    int totalFrames = metadata->totalFrames;
+    int sweep;
+
+    // Two full sweeps are enough: the first clears every reference bit
+    for (sweep = 0; sweep <= 2 * totalFrames; sweep++)
+    {
+        int index = metadata->clockHand % totalFrames;
+        Frame *frame = frameAt(metadata, index);
+
+        // Advance clock hand; pages hinted hotter than the pass allows
+        // keep their reference bit
+        metadata->clockHand = (index + 1) % totalFrames;
+        if (hintRank(frame) > maxRank)
+            continue;
+
+        // Found an unpinned page with no recent access
+        if (isEvictable(frame) && RELAXED_LOAD(&frame->accessCount) == 0)
+            return index;
+
+        // Give second chance by resetting access count
+        if (RELAXED_LOAD(&frame->accessCount) > 0)
+            RELAXED_STORE(&frame->accessCount, 0);
+    }
+
+    return NO_FRAME;
+}
+
+/**
+ * Runs the pool's strategy over the frames whose hint ranks at most maxRank
+ */
+static int replaceWithStrategy(BufferPoolMetadata *metadata, int maxRank)
+{
+    switch (metadata->strategy)
+    {
+    case RS_FIFO:
+        return replaceFIFO(metadata, maxRank);
+    case RS_LRU:
+        return replaceLRU(metadata, maxRank);
+    case RS_CLOCK:
+        return replaceCLOCK(metadata, maxRank);
+    case RS_LFU:
+        return replaceLFU(metadata, maxRank);
+    default:
+        return NO_FRAME; // refused when the pool is created
+    }
+}
+
+/**
+ * Checks whether the buffer manager can select victims with a strategy;
+ * LRU-K has no victim selection yet
+ */
+static bool strategyImplemented(ReplacementStrategy strategy)
+{
+    return strategy == RS_FIFO || strategy == RS_LRU || strategy == RS_CLOCK || strategy == RS_LFU;
+}
+
+/**
+ * Picks a victim frame using the pool's strategy; caller holds replLatch.
+ * Cold pages are tried first and hot pages only when no other page can
+ * be evicted; without hinted pages this is a single pass.
+ */
+static int selectVictim(BufferPoolMetadata *metadata)
+{
+    int rank = (ATOMIC_LOAD(&metadata->numColdFrames) > 0) ? 0 : 1;
+    int maxRank = (ATOMIC_LOAD(&metadata->numHotFrames) > 0) ? 2 : 1;
+    int victim = NO_FRAME;
+
+    for (; victim == NO_FRAME && rank <= maxRank; rank++)
+        victim = replaceWithStrategy(metadata, rank);
+    return victim;
+}
+
+/**
+ * Returns an empty frame to the pool so victim selection picks it first
+ */
+static void releaseFrame(Frame *frame)
+{
+    RELAXED_STORE(&frame->accessCount, 0);
+    RELAXED_STORE(&frame->lastAccessed, 0);
+    ATOMIC_DEC(&frame->pinCount);
+}
+
+/**
+ * Evicts pages to obtain empty frames, each pinned once for the caller.
+ *
+ * Unused frames are handed out first. Otherwise victims are chosen under the
+ * replacement latch, which is taken once for the whole request, and claimed
+ * under their page-table partition latch. A dirty victim is written back
+ * with every latch released; if somebody pins or dirties the page
+ * meanwhile, the victim is kept and another one is chosen. Victims may
+ * belong to any file registered with the pool. The writes are counted as
+ * foreground writes, or as background writes for the evictor. Returns the
+ * number of frames obtained in *numAcquired, also when fewer than count
+ * could be had.
+ */
+static RC evictFrames(BufferPoolMetadata *metadata, int count, int *result, int *numAcquired,
+                      bool background)
+{
+    int acquired = 0, failures = 0;
+    RC rc = RC_OK;
+
+    pthread_mutex_lock(&metadata->replLatch);
 
-    // Move to current clock hand position
-    for (i = 0; i < metadata->clockHand; i++)
+    // Hand out the frames never used so far
+    while (acquired < count && metadata->numFramesUsed < metadata->totalFrames)
     {
-        if (current->next != NULL)
+        int index = metadata->numFramesUsed++;
+        ATOMIC_STORE(&frameAt(metadata, index)->pinCount, 1);
+        result[acquired++] = index;
+    }
+
+    while (acquired < count && failures < 2 * metadata->totalFrames)
+    {
+        int index = selectVictim(metadata);
+        if (index == NO_FRAME)
+            break;
+
+        Frame *victim = frameAt(metadata, index);
+        PageNumber oldPage = ATOMIC_LOAD(&victim->pageNum);
+        int oldFile = ATOMIC_LOAD(&victim->fileId);
+
+        // An empty frame only has to be claimed
+        if (oldPage == NO_PAGE)
+        {
+            int unpinned = 0;
+            if (ATOMIC_CAS(&victim->pinCount, &unpinned, 1))
+                result[acquired++] = index;
+            else
+                failures++;
+            continue;
+        }
+
+        PageTablePartition *part = partitionFor(metadata, oldFile, oldPage);
+        pthread_mutex_lock(&part->latch);
+
+        // Recheck now that new pins of the page are excluded
+        if (!holdsPage(victim, oldFile, oldPage) || victim->ioInProgress ||
+            ATOMIC_LOAD(&victim->pinCount) != 0)
+        {
+            pthread_mutex_unlock(&part->latch);
+            failures++;
+            continue;
+        }
+        ATOMIC_STORE(&victim->pinCount, 1);
+
+        if (!ATOMIC_LOAD(&victim->isDirty))
+        {
+            removeFrame(metadata, part, index);
+            setFrameHint(metadata, victim, BM_HINT_NONE);
+            ATOMIC_STORE(&victim->pageNum, NO_PAGE);
+            pthread_mutex_unlock(&part->latch);
+            COUNT_EVENT(metadata, oldFile, cleanEvictions);
+            result[acquired++] = index;
+            continue;
+        }
+
+        // The victim page is dirty: write it to disk without holding the
+        // replacement latch, so hits and other misses proceed meanwhile
+        ATOMIC_STORE(&victim->ioInProgress, true);
+        pthread_mutex_unlock(&part->latch);
+        pthread_mutex_unlock(&metadata->replLatch);
+
+        ATOMIC_STORE(&victim->isDirty, false);
+        rc = writePageData(metadata, oldFile, oldPage, victim->data);
+
+        pthread_mutex_lock(&part->latch);
+        ATOMIC_STORE(&victim->ioInProgress, false);
+        pthread_cond_broadcast(&part->ioDone);
+
+        if (rc != RC_OK)
         {
-            current = current->next;
+            ATOMIC_STORE(&victim->isDirty, true);
+            ATOMIC_DEC(&victim->pinCount);
+            pthread_mutex_unlock(&part->latch);
+            *numAcquired = acquired;
+            return rc;
+        }
+        if (background)
+            COUNT_EVENT(metadata, oldFile, bgWriteCount);
+        else
+            COUNT_EVENT(metadata, oldFile, fgWriteCount);
+
+        if (ATOMIC_LOAD(&victim->pinCount) == 1 && !ATOMIC_LOAD(&victim->isDirty))
+        {
+            removeFrame(metadata, part, index);
+            setFrameHint(metadata, victim, BM_HINT_NONE);
+            ATOMIC_STORE(&victim->pageNum, NO_PAGE);
+            COUNT_EVENT(metadata, oldFile, dirtyEvictions);
+            result[acquired++] = index;
         }
         else
         {
-            current = metadata->head; // Wrap around
+            // The page was pinned or modified while it was written; keep it
+            ATOMIC_DEC(&victim->pinCount);
+            failures++;
         }
+        pthread_mutex_unlock(&part->latch);
+        pthread_mutex_lock(&metadata->replLatch);
     }
 
-    // Keep searching until victim found
-    while (true)
+    pthread_mutex_unlock(&metadata->replLatch);
+    *numAcquired = acquired;
+    return (acquired == count) ? RC_OK : RC_ERROR; // Every other frame is pinned
+}
+
+/**
+ * Obtains empty frames, each pinned once for the caller.
+ *
+ * Frames are popped off the free-frame list first; only what the list
+ * cannot supply is evicted inline. Wakes the evictor once the list falls
+ * below its low watermark. Returns the number of frames obtained in
+ * *numAcquired, also when fewer than count could be had.
+ */
+static RC acquireFrames(BufferPoolMetadata *metadata, int count, int *result, int *numAcquired)
+{
+    int popped = 0, evicted = 0;
+    RC rc = RC_OK;
+
+    if (ATOMIC_LOAD(&metadata->numFree) > 0 || ATOMIC_LOAD(&metadata->evictorRunning))
     {
-        // Found an unpinned page with no recent access
-        if (current->pinCount == 0 && current->accessCount == 0)
+        pthread_mutex_lock(&metadata->freeLatch);
+        while (popped < count && metadata->numFree > 0)
         {
-            metadata->clockHand = (metadata->clockHand + 1) % metadata->totalFrames;
-            return current;
+            ATOMIC_STORE(&metadata->numFree, metadata->numFree - 1);
+            result[popped++] = metadata->freeFrames[metadata->numFree];
         }
+        if (metadata->evictorRunning && metadata->numFree < metadata->lowWatermark)
+            pthread_cond_signal(&metadata->evictorWake);
+        pthread_mutex_unlock(&metadata->freeLatch);
+    }
 
-        // Give second chance by resetting access count
-        if (current->accessCount > 0)
-        {
-            current->accessCount = 0;
-        }
+    if (popped < count)
+        rc = evictFrames(metadata, count - popped, result + popped, &evicted, false);
+    *numAcquired = popped + evicted;
+    return rc;
+}
+
+/**
+ * Obtains one empty frame, pinned once for the caller
+ */
+static RC acquireFrame(BufferPoolMetadata *metadata, int *result)
+{
+    int acquired;
+    return acquireFrames(metadata, 1, result, &acquired);
+}
+
+/**
+ * Pins a frame already mapped to a page, waiting for in-flight I/O on it.
+ * Caller holds the partition latch; returns false if the load failed.
+ */
+static bool pinMappedFrame(BufferPoolMetadata *metadata, PageTablePartition *part,
+                           int index, int fileId, PageNumber pageNum)
+{
+    Frame *frame = frameAt(metadata, index);
+
+    ATOMIC_INC(&frame->pinCount);
+
+    // Concurrent misses on the same page wait for the single read in flight
+    if (frame->ioInProgress)
+        COUNT_EVENT(metadata, fileId, pinWaits);
+    while (frame->ioInProgress)
+        pthread_cond_wait(&part->ioDone, &part->latch);
+
+    if (!holdsPage(frame, fileId, pageNum))
+    {
+        // The read failed and the frame was given up
+        releaseFrame(frame);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Records an access to a pinned frame for the replacement strategies
+ */
+static void touchFrame(BufferPoolMetadata *metadata, Frame *frame)
+{
+    COUNTER_INC(&frame->accessCount);
+    RELAXED_STORE(&frame->lastAccessed, ATOMIC_INC(&metadata->globalTimer));
+}
+
+/**
+ * Writes the buffered trace records to the trace file; caller holds traceLatch
+ */
+static void flushTrace(BufferPoolMetadata *metadata)
+{
+    if (metadata->traceCount > 0 &&
+        fwrite(metadata->traceBuffer, sizeof(BM_TraceRecord), metadata->traceCount,
+               metadata->traceFile) != (size_t)metadata->traceCount)
+        metadata->traceFailed = true;
+    metadata->traceCount = 0;
+}
+
+/**
+ * Appends a page access to the trace, if one is being recorded. Records
+ * are stamped under the trace latch, so the trace is in time order.
+ */
+static void traceAccess(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, BM_TraceOp op)
+{
+    struct timespec now;
+
+    if (!ATOMIC_LOAD(&metadata->tracing))
+        return;
+
+    pthread_mutex_lock(&metadata->traceLatch);
+    if (metadata->tracing)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        BM_TraceRecord *record = &metadata->traceBuffer[metadata->traceCount++];
+        record->timestamp = (now.tv_sec - metadata->traceStart.tv_sec) * 1000000000L +
+                            (now.tv_nsec - metadata->traceStart.tv_nsec);
+        record->pageNum = pageNum;
+        record->file = (unsigned short)fileId;
+        record->op = (unsigned char)op;
+        record->reserved = 0;
+        if (metadata->traceCount == BM_TRACE_BUFFER_RECORDS)
+            flushTrace(metadata);
+    }
+    pthread_mutex_unlock(&metadata->traceLatch);
+}
+
+/**
+ * Makes a page resident and returns its frame, pinned if requested.
+ *
+ * A hit pins the mapped frame, waiting for a read in flight. A miss
+ * obtains an empty frame, publishes the page in the page table as being
+ * loaded, and reads it with no latch held.
+ */
+static RC loadPage(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum,
+                   bool pin, int *result)
+{
+    PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+    int index;
+
+    while (true)
+    {
+        // Check if the page is already in the buffer pool
+        pthread_mutex_lock(&part->latch);
+        index = findFrame(metadata, part, fileId, pageNum);
+        if (index != NO_FRAME)
+        {
+            if (!pin)
+            {
+                pthread_mutex_unlock(&part->latch);
+                *result = index;
+                return RC_OK;
+            }
+
+            bool loaded = pinMappedFrame(metadata, part, index, fileId, pageNum);
+            pthread_mutex_unlock(&part->latch);
+            if (!loaded)
+                continue;
+            COUNT_EVENT(metadata, fileId, hits);
+            touchFrame(metadata, frameAt(metadata, index));
+            *result = index;
+            return RC_OK;
+        }
+        pthread_mutex_unlock(&part->latch);
+
+        // Obtain an empty frame for the page
+        RC rc = acquireFrame(metadata, &index);
+        if (rc != RC_OK)
+            return rc;
+        Frame *frame = frameAt(metadata, index);
+
+        pthread_mutex_lock(&part->latch);
+
+        // Another thread may have loaded the page meanwhile
+        if (findFrame(metadata, part, fileId, pageNum) != NO_FRAME)
+        {
+            releaseFrame(frame);
+            pthread_mutex_unlock(&part->latch);
+            continue;
+        }
+
+        // Publish the page as being loaded, then read it with no latch held
+        bumpVersion(frame);
+        ATOMIC_STORE(&frame->fileId, fileId);
+        ATOMIC_STORE(&frame->pageNum, pageNum);
+        ATOMIC_STORE(&frame->ioInProgress, true);
+        ATOMIC_STORE(&frame->isDirty, false);
+        RELAXED_STORE(&frame->accessCount, 1);
+        RELAXED_STORE(&frame->lastAccessed, ATOMIC_INC(&metadata->globalTimer));
+        insertFrame(metadata, part, index);
+        pthread_mutex_unlock(&part->latch);
+
+        rc = readPageData(metadata, fileId, pageNum, frame->data);
+        if (pin)
+            COUNT_EVENT(metadata, fileId, misses);
+
+        pthread_mutex_lock(&part->latch);
+        ATOMIC_STORE(&frame->ioInProgress, false);
+        bumpVersion(frame);
+        if (rc != RC_OK)
+        {
+            removeFrame(metadata, part, index);
+            ATOMIC_STORE(&frame->pageNum, NO_PAGE);
+            releaseFrame(frame);
+        }
+        else if (!pin)
+        {
+            ATOMIC_DEC(&frame->pinCount);
+        }
+        pthread_cond_broadcast(&part->ioDone);
+        pthread_mutex_unlock(&part->latch);
+
+        *result = index;
+        return rc;
+    }
+}
+
+/**
+ * Registers a page file with the pool, or takes another reference on it
+ * if the file is registered already, so all its handles share the frames.
+ * A NULL name registers a new memory-only file that does no I/O.
+ */
+static RC registerFile(BufferPoolMetadata *metadata, const char *fileName, int *result)
+{
+    PoolFile *file = NULL;
+    int slot;
+
+    pthread_mutex_lock(&metadata->filesLatch);
+    for (slot = 0; slot < BM_MAX_FILES; slot++)
+    {
+        PoolFile *candidate = &metadata->files[slot];
+        if (candidate->fileId == NO_FILE)
+        {
+            if (file == NULL)
+                file = candidate;
+        }
+        else if (fileName != NULL && candidate->fileName != NULL &&
+                 strcmp(candidate->fileName, fileName) == 0)
+        {
+            candidate->refCount++;
+            *result = candidate->fileId;
+            pthread_mutex_unlock(&metadata->filesLatch);
+            return RC_OK;
+        }
+    }
+
+    if (file == NULL)
+    {
+        pthread_mutex_unlock(&metadata->filesLatch);
+        return RC_ERROR; // File table is full
+    }
+
+    pthread_mutex_lock(&file->latch);
+    RC rc = (fileName == NULL) ? RC_OK : openPageFile((char *)fileName, &file->fileHandle);
+    if (rc == RC_OK)
+    {
+        file->inMemory = (fileName == NULL);
+        file->generation++;
+        file->fileId = file->generation * BM_MAX_FILES + (int)(file - metadata->files);
+        file->refCount = 1;
+        file->fileName = (fileName == NULL) ? NULL : strdup(fileName);
+        memset(&file->stats, 0, sizeof(PoolCounters));
+        *result = file->fileId;
+    }
+    pthread_mutex_unlock(&file->latch);
+    pthread_mutex_unlock(&metadata->filesLatch);
+
+    return rc;
+}
+
+/**
+ * Writes back and drops every page of a file. Stops with
+ * RC_PINNED_PAGES_IN_BUFFER at the first page a client still has pinned;
+ * the pages dropped until then are simply read again on their next pin.
+ */
+static RC evictFile(BufferPoolMetadata *metadata, int fileId)
+{
+    RC rc;
+    int i;
+
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        PageNumber pageNum = ATOMIC_LOAD(&frame->pageNum);
+        if (pageNum == NO_PAGE || ATOMIC_LOAD(&frame->fileId) != fileId)
+            continue;
+
+        PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+        while (true)
+        {
+            flushFrame(metadata, i, fileId, &rc);
+            if (rc != RC_OK)
+                return rc;
+
+            pthread_mutex_lock(&part->latch);
+            if (!holdsPage(frame, fileId, pageNum))
+            {
+                pthread_mutex_unlock(&part->latch);
+                break;
+            }
+
+            // Wait for a load, write-back or eviction in flight on the page
+            if (frame->ioInProgress)
+            {
+                pthread_cond_wait(&part->ioDone, &part->latch);
+                pthread_mutex_unlock(&part->latch);
+                continue;
+            }
+
+            // Outside of I/O only clients hold pins
+            if (ATOMIC_LOAD(&frame->pinCount) > 0)
+            {
+                pthread_mutex_unlock(&part->latch);
+                return RC_PINNED_PAGES_IN_BUFFER;
+            }
+
+            if (!ATOMIC_LOAD(&frame->isDirty))
+            {
+                removeFrame(metadata, part, i);
+                setFrameHint(metadata, frame, BM_HINT_NONE);
+                ATOMIC_STORE(&frame->pageNum, NO_PAGE);
+                RELAXED_STORE(&frame->accessCount, 0);
+                RELAXED_STORE(&frame->lastAccessed, 0);
+                pthread_mutex_unlock(&part->latch);
+                break;
+            }
+            pthread_mutex_unlock(&part->latch);
+        }
+    }
+    return RC_OK;
+}
+
+/**
+ * Drops a reference on a registered file. The last reference writes back
+ * and evicts the file's pages and closes it; this fails with
+ * RC_PINNED_PAGES_IN_BUFFER while any of its pages is pinned.
+ */
+static RC unregisterFile(BufferPoolMetadata *metadata, int fileId)
+{
+    PoolFile *file = fileFor(metadata, fileId);
+    RC rc = RC_OK;
+    int i;
+
+    pthread_mutex_lock(&metadata->filesLatch);
+    if (file->refCount > 1)
+    {
+        file->refCount--;
+        pthread_mutex_unlock(&metadata->filesLatch);
+        return RC_OK;
+    }
+
+    rc = evictFile(metadata, fileId);
+    if (rc != RC_OK)
+    {
+        pthread_mutex_unlock(&metadata->filesLatch);
+        return rc;
+    }
+
+    // Drop queued prefetches of the file, they would fail anyway
+    pthread_mutex_lock(&metadata->prefetchLatch);
+    int kept = 0;
+    for (i = 0; i < metadata->prefetchCount; i++)
+    {
+        PageRequest request = metadata->prefetchQueue[(metadata->prefetchHead + i) % BM_PREFETCH_QUEUE_SIZE];
+        if (request.fileId != fileId)
+            metadata->prefetchQueue[(metadata->prefetchHead + kept++) % BM_PREFETCH_QUEUE_SIZE] = request;
+    }
+    metadata->prefetchCount = kept;
+    pthread_mutex_unlock(&metadata->prefetchLatch);
+
+    pthread_mutex_lock(&file->latch);
+    file->fileId = NO_FILE;
+    file->refCount = 0;
+    if (!file->inMemory)
+        rc = closePageFile(&file->fileHandle);
+    free(file->fileName);
+    file->fileName = NULL;
+    pthread_mutex_unlock(&file->latch);
+    pthread_mutex_unlock(&metadata->filesLatch);
+
+    return rc;
+}
+
+/**
+ * Maps the memory of one extent's frames. Explicit huge pages come from the
+ * hugetlb pool and fall back to transparent ones if it is empty; those are
+ * requested for a mapping aligned to the huge page size, which the kernel
+ * may or may not honor. Reports in *backing what the arena was mapped with.
+ */
+static char *mapArena(BM_HugePages hugePages, BM_HugePages *backing)
+{
+    char *arena;
+
+    *backing = BM_HUGE_PAGES_NONE;
+    if (hugePages == BM_HUGE_PAGES_NONE || BM_ARENA_SIZE % BM_HUGE_PAGE_SIZE != 0)
+        return mmap(NULL, BM_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#ifdef MAP_HUGETLB
+    if (hugePages == BM_HUGE_PAGES_EXPLICIT)
+    {
+        arena = mmap(NULL, BM_ARENA_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (arena != MAP_FAILED)
+        {
+            *backing = BM_HUGE_PAGES_EXPLICIT;
+            return arena;
+        }
+    }
+#endif
+
+    // Map one huge page more than needed and trim it to an aligned arena
+    arena = mmap(NULL, BM_ARENA_SIZE + BM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED)
+        return arena;
+    size_t head = (BM_HUGE_PAGE_SIZE - (uintptr_t)arena % BM_HUGE_PAGE_SIZE) % BM_HUGE_PAGE_SIZE;
+    if (head > 0)
+        munmap(arena, head);
+    munmap(arena + head + BM_ARENA_SIZE, BM_HUGE_PAGE_SIZE - head);
+    arena += head;
+
+#ifdef MADV_HUGEPAGE
+    if (madvise(arena, BM_ARENA_SIZE, MADV_HUGEPAGE) == 0)
+        *backing = BM_HUGE_PAGES_TRANSPARENT;
+#endif
+    return arena;
+}
+
+/**
+ * Maps memory for frames up to the given count, one extent at a time.
+ * Extents are never moved or freed before the pool is destroyed, so
+ * frames can be reached without any latch. Caller holds resizeLatch.
+ */
+static RC allocateFrames(BufferPoolMetadata *metadata, int numFrames)
+{
+    int i;
+
+    if (numFrames > BM_MAX_EXTENTS * BM_EXTENT_FRAMES)
+        return RC_INVALID_PARAMETER;
+
+    while (metadata->numExtents * BM_EXTENT_FRAMES < numFrames)
+    {
+        // Anonymous mappings only take memory once a frame is used
+        BM_HugePages backing;
+        Frame *extent = (Frame *)calloc(BM_EXTENT_FRAMES, sizeof(Frame));
+        char *arena = mapArena(metadata->hugePages, &backing);
+        if (extent == NULL || arena == MAP_FAILED)
+        {
+            free(extent);
+            if (arena != MAP_FAILED)
+                munmap(arena, BM_ARENA_SIZE);
+            return RC_MEMORY_ALLOCATION_ERROR;
+        }
+
+        for (i = 0; i < BM_EXTENT_FRAMES; i++)
+        {
+            extent[i].data = arena + (size_t)i * PAGE_SIZE;
+            extent[i].fileId = NO_FILE;
+            extent[i].pageNum = NO_PAGE;
+            extent[i].hashNext = NO_FRAME;
+        }
+        metadata->extents[metadata->numExtents] = extent;
+        metadata->arenas[metadata->numExtents] = arena;
+        metadata->arenaPages[metadata->numExtents] = backing;
+        ATOMIC_STORE(&metadata->numExtents, metadata->numExtents + 1);
+    }
+    return RC_OK;
+}
+
+/**
+ * Grows the hash chains of every partition for a load factor of about one
+ * half at the given number of frames. Each partition is rehashed under its
+ * own latch, so pins of other partitions go on meanwhile.
+ */
+static RC growPageTable(BufferPoolMetadata *metadata, int numFrames)
+{
+    int numBuckets = (2 * numFrames + BM_PAGE_TABLE_PARTITIONS - 1) / BM_PAGE_TABLE_PARTITIONS;
+    int i, j;
+
+    for (i = 0; i < BM_PAGE_TABLE_PARTITIONS; i++)
+    {
+        PageTablePartition *part = &metadata->partitions[i];
+        if (part->numBuckets >= numBuckets)
+            continue;
+
+        int *buckets = (int *)malloc(sizeof(int) * numBuckets);
+        if (buckets == NULL)
+            return RC_MEMORY_ALLOCATION_ERROR;
+        for (j = 0; j < numBuckets; j++)
+            buckets[j] = NO_FRAME;
+
+        pthread_mutex_lock(&part->latch);
+        int *oldBuckets = part->buckets;
+        int oldNumBuckets = part->numBuckets;
+        part->buckets = buckets;
+        part->numBuckets = numBuckets;
+
+        // Move every chained frame over to the new chains
+        for (j = 0; j < oldNumBuckets; j++)
+        {
+            int index = oldBuckets[j];
+            while (index != NO_FRAME)
+            {
+                int next = frameAt(metadata, index)->hashNext;
+                insertFrame(metadata, part, index);
+                index = next;
+            }
+        }
+        pthread_mutex_unlock(&part->latch);
+        free(oldBuckets);
+    }
+    return RC_OK;
+}
+
+/**
+ * Allocates an empty pool with its frames, arenas and page table
+ */
+static BufferPoolMetadata *createPool(int numPages, ReplacementStrategy strategy,
+                                      BM_HugePages hugePages)
+{
+    int i;
+
+    // Allocate and initialize metadata structure
+    BufferPoolMetadata *metadata = (BufferPoolMetadata *)calloc(1, sizeof(BufferPoolMetadata));
+    if (metadata == NULL)
+        return NULL;
+
+    for (i = 0; i < BM_PAGE_TABLE_PARTITIONS; i++)
+    {
+        pthread_mutex_init(&metadata->partitions[i].latch, NULL);
+        pthread_cond_init(&metadata->partitions[i].ioDone, NULL);
+        pthread_cond_init(&metadata->partitions[i].latchFree, NULL);
+    }
+
+    for (i = 0; i < BM_MAX_FILES; i++)
+    {
+        pthread_mutex_init(&metadata->files[i].latch, NULL);
+        metadata->files[i].fileId = NO_FILE;
+    }
+
+    pthread_mutex_init(&metadata->replLatch, NULL);
+    pthread_mutex_init(&metadata->resizeLatch, NULL);
+    pthread_mutex_init(&metadata->filesLatch, NULL);
+    pthread_mutex_init(&metadata->writerLatch, NULL);
+    pthread_cond_init(&metadata->writerWake, NULL);
+    pthread_mutex_init(&metadata->prefetchLatch, NULL);
+    pthread_cond_init(&metadata->prefetchWake, NULL);
+    pthread_mutex_init(&metadata->traceLatch, NULL);
+    pthread_mutex_init(&metadata->freeLatch, NULL);
+    pthread_cond_init(&metadata->evictorWake, NULL);
+    pthread_mutex_init(&metadata->checkpointLatch, NULL);
+    pthread_cond_init(&metadata->checkpointWake, NULL);
+    metadata->strategy = strategy;
+    metadata->hugePages = hugePages;
+
+    if (allocateFrames(metadata, numPages) != RC_OK || growPageTable(metadata, numPages) != RC_OK)
+    {
+        destroyPool(metadata);
+        return NULL;
+    }
+    metadata->totalFrames = numPages;
+
+    return metadata;
+}
+
+/**
+ * Frees a pool; every file must be unregistered, the threads stopped and
+ * the trace closed
+ */
+static void destroyPool(BufferPoolMetadata *metadata)
+{
+    int i;
+
+    for (i = 0; i < BM_PAGE_TABLE_PARTITIONS; i++)
+    {
+        pthread_mutex_destroy(&metadata->partitions[i].latch);
+        pthread_cond_destroy(&metadata->partitions[i].ioDone);
+        pthread_cond_destroy(&metadata->partitions[i].latchFree);
+        free(metadata->partitions[i].buckets);
+    }
+    for (i = 0; i < BM_MAX_FILES; i++)
+        pthread_mutex_destroy(&metadata->files[i].latch);
+    pthread_mutex_destroy(&metadata->replLatch);
+    pthread_mutex_destroy(&metadata->resizeLatch);
+    pthread_mutex_destroy(&metadata->filesLatch);
+    pthread_mutex_destroy(&metadata->writerLatch);
+    pthread_cond_destroy(&metadata->writerWake);
+    pthread_mutex_destroy(&metadata->prefetchLatch);
+    pthread_cond_destroy(&metadata->prefetchWake);
+    pthread_mutex_destroy(&metadata->traceLatch);
+    pthread_mutex_destroy(&metadata->freeLatch);
+    pthread_cond_destroy(&metadata->evictorWake);
+    pthread_mutex_destroy(&metadata->checkpointLatch);
+    pthread_cond_destroy(&metadata->checkpointWake);
+    free(metadata->freeFrames);
+    for (i = 0; i < metadata->numExtents; i++)
+    {
+        munmap(metadata->arenas[i], BM_ARENA_SIZE);
+        free(metadata->extents[i]);
+    }
+
+    // Free metadata structure
+    free(metadata);
+}
+
+/**
+ * Returns the pool behind a handle
+ */
+static BufferPoolMetadata *poolOf(BM_BufferPool *const bm)
+{
+    return ((PoolHandle *)bm->mgmtData)->pool;
+}
+
+/**
+ * Returns the file a handle is bound to, NO_FILE for a bare shared pool
+ */
+static int fileOf(BM_BufferPool *const bm)
+{
+    return ((PoolHandle *)bm->mgmtData)->fileId;
+}
+
+/**
+ * Checks whether a frame is visible through a handle: a handle bound to a
+ * file sees only that file's pages, a bare shared pool sees all of them
+ */
+static bool frameVisible(BM_BufferPool *const bm, Frame *frame)
+{
+    int fileId = fileOf(bm);
+    return fileId == NO_FILE || ATOMIC_LOAD(&frame->fileId) == fileId;
+}
+
+/**
+ * Returns the I/O counters reported through a handle
+ */
+static PoolCounters *countersOf(BM_BufferPool *const bm)
+{
+    int fileId = fileOf(bm);
+    if (fileId == NO_FILE)
+        return &poolOf(bm)->stats;
+    return &fileFor(poolOf(bm), fileId)->stats;
+}
+
+/**
+ * Creates a pool owned by the handle, with its frames backed as requested
+ */
+static RC openPool(BM_BufferPool *const bm, const char *const pageFileName, int numPages,
+                   ReplacementStrategy strategy, BM_HugePages hugePages)
+{
+    if (numPages <= 0 || !strategyImplemented(strategy))
+        return RC_INVALID_PARAMETER;
+
+    PoolHandle *handle = (PoolHandle *)malloc(sizeof(PoolHandle));
+    BufferPoolMetadata *metadata = createPool(numPages, strategy, hugePages);
+    if (handle == NULL || metadata == NULL)
+    {
+        free(handle);
+        if (metadata != NULL)
+            destroyPool(metadata);
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+
+    RC rc = registerFile(metadata, pageFileName, &handle->fileId);
+    if (rc != RC_OK)
+    {
+        destroyPool(metadata);
+        free(handle);
+        return rc;
+    }
+    handle->pool = metadata;
+    handle->ownsPool = true;
+    handle->warmFile = NULL;
+
+    // Initialize buffer pool handle
+    bm->pageFile = (char *)pageFileName;
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+    bm->mgmtData = handle;
+
+    return RC_OK;
+}
+
+/**
+ * Creates a new buffer pool and initializes required data structures.
+ *
+ * @param bm Buffer pool handle to initialize
+ * @param pageFileName Name of the page file to use, NULL for no page file
+ * @param numPages Number of pages the buffer pool can hold
+ * @param strategy Page replacement strategy to use
+ * @param stratData Additional data for replacement strategy (if needed)
+ * @return RC_OK on successful initialization, RC_FILE_NOT_FOUND if the page
+ *         file cannot be opened, RC_INVALID_PARAMETER for a bad size or a
+ *         strategy without victim selection (RS_LRU_K),
+ *         RC_MEMORY_ALLOCATION_ERROR if out of memory
+ *
+ * Allocates the frame descriptors, their arenas of normal pages, and the
+ * partitioned page table. The page file stays open for the lifetime
+ * of the pool. The buffer pool starts empty with no frames used. Further
+ * files can share the pool through attachBufferPool.
+ *
+ * Without a page file the pool does no I/O: pages are zeroed when they are
+ * first pinned and dropped when evicted, while all statistics are kept as
+ * if the reads and writes had happened. bm_sim uses such pools to replay traces.
+ */
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy, void *stratData)
+{
+    return openPool(bm, pageFileName, numPages, strategy, BM_HUGE_PAGES_NONE);
+}
+
+/**
+ * Creates a buffer pool with optional warm-up across restarts.
+ *
+ * @param bm Buffer pool handle to initialize
+ * @param pageFileName Name of the page file to use
+ * @param numPages Number of pages the buffer pool can hold
+ * @param strategy Page replacement strategy to use
+ * @param stratData Additional data for replacement strategy (if needed)
+ * @param options Warm-up and memory options, NULL for the defaults of
+ *        initBufferPool
+ * @return RC_OK on success, otherwise the error of initBufferPool
+ *
+ * Works like initBufferPool. With loadOnStart the pages listed in the
+ * warm-up file are read back before the function returns, so the pool
+ * serves its first requests warm; a missing or damaged file leaves the
+ * pool cold without failing. With dumpOnShutdown shutdownBufferPool
+ * writes the resident pages to the warm-up file.
+ *
+ * hugePages backs the frames of the pool, including those added by
+ * resizeBufferPool, with huge pages: BM_HUGE_PAGES_TRANSPARENT advises the
+ * kernel to use transparent huge pages, BM_HUGE_PAGES_EXPLICIT maps them
+ * from the reserved hugetlb pool and falls back to transparent ones when
+ * it is exhausted. Large pools then need far fewer TLB entries for their
+ * replacement sweeps and page copies. Frames retired by shrinking an
+ * explicitly backed pool keep their memory. The hugePageFrames statistic
+ * tells which frames got huge pages.
+ */
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                             const int numPages, ReplacementStrategy strategy, void *stratData,
+                             const BM_PoolOptions *options)
+{
+    RC rc = openPool(bm, pageFileName, numPages, strategy,
+                     (options != NULL) ? options->hugePages : BM_HUGE_PAGES_NONE);
+    if (rc != RC_OK || options == NULL)
+        return rc;
+
+    if (options->dumpOnShutdown)
+        ((PoolHandle *)bm->mgmtData)->warmFile = warmFileName(bm, options->warmFile);
+    if (options->loadOnStart)
+        loadBufferPool(bm, options->warmFile);
+
+    return RC_OK;
+}
+
+/**
+ * Creates a buffer pool that is not bound to a page file.
+ *
+ * @param bm Buffer pool handle to initialize
+ * @param numPages Number of pages the buffer pool can hold
+ * @param strategy Page replacement strategy, applied across all files
+ * @param stratData Additional data for replacement strategy (if needed)
+ * @return RC_OK on success, RC_INVALID_PARAMETER for a bad size or an
+ *         unimplemented strategy, RC_MEMORY_ALLOCATION_ERROR if out of memory
+ *
+ * Page files are registered with the pool through attachBufferPool. Their
+ * pages compete for the same frames, so one memory budget serves all of
+ * them and files that are not used give their frames up to busy ones.
+ * Page access functions fail on this handle since it has no file; the
+ * statistics functions report on the whole pool.
+ */
+RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages,
+                        ReplacementStrategy strategy, void *stratData)
+{
+    if (numPages <= 0 || !strategyImplemented(strategy))
+        return RC_INVALID_PARAMETER;
+
+    PoolHandle *handle = (PoolHandle *)malloc(sizeof(PoolHandle));
+    BufferPoolMetadata *metadata = createPool(numPages, strategy, BM_HUGE_PAGES_NONE);
+    if (handle == NULL || metadata == NULL)
+    {
+        free(handle);
+        if (metadata != NULL)
+            destroyPool(metadata);
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+    handle->pool = metadata;
+    handle->fileId = NO_FILE;
+    handle->ownsPool = true;
+    handle->warmFile = NULL;
+
+    bm->pageFile = NULL;
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+    bm->mgmtData = handle;
+
+    return RC_OK;
+}
+
+/**
+ * Opens a page file through an existing buffer pool.
+ *
+ * @param bm Buffer pool handle to initialize for the file
+ * @param pool Handle of the pool to share, e.g. from initSharedBufferPool
+ * @param pageFileName Name of the page file to use, NULL for a
+ *        memory-only file as with initBufferPool
+ * @return RC_OK on success, RC_FILE_NOT_FOUND if the page file cannot be
+ *         opened, RC_ERROR if the pool's file table is full
+ *
+ * The new handle works like one from initBufferPool, but its pages live in
+ * the frames of the shared pool; the page table is keyed by file and page
+ * number. Handles attached to the same file name share its pages.
+ * Shutting the handle down detaches it; the pool itself stays up until
+ * the handle that created it is shut down.
+ */
+RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const pool,
+                    const char *const pageFileName)
+{
+    BufferPoolMetadata *metadata = poolOf(pool);
+
+    PoolHandle *handle = (PoolHandle *)malloc(sizeof(PoolHandle));
+    if (handle == NULL)
+        return RC_MEMORY_ALLOCATION_ERROR;
+
+    RC rc = registerFile(metadata, pageFileName, &handle->fileId);
+    if (rc != RC_OK)
+    {
+        free(handle);
+        return rc;
+    }
+    handle->pool = metadata;
+    handle->ownsPool = false;
+    handle->warmFile = NULL;
+
+    pthread_mutex_lock(&metadata->filesLatch);
+    metadata->numAttached++;
+    pthread_mutex_unlock(&metadata->filesLatch);
+
+    bm->pageFile = (char *)pageFileName;
+    pthread_mutex_lock(&metadata->resizeLatch);
+    bm->numPages = ATOMIC_LOAD(&metadata->totalFrames) - metadata->numRetired;
+    pthread_mutex_unlock(&metadata->resizeLatch);
+    bm->strategy = metadata->strategy;
+    bm->mgmtData = handle;
+
+    return RC_OK;
+}
+
+/**
+ * Shuts down an existing buffer pool and releases all resources.
+ *
+ * @param bm Buffer pool handle to shut down
+ * @return RC_OK on success, RC_PINNED_PAGES_IN_BUFFER if pages still pinned,
+ *         RC_BUFFER_POOL_IN_USE if other handles are still attached
+ *
+ * Stops the helper threads, verifies no pages are pinned, forces all
+ * dirty pages to disk, and frees all allocated memory. The pool is left
+ * usable if a page is still pinned, so the caller can unpin and retry.
+ * Must not race with other operations on the same pool. A pool opened
+ * with dumpOnShutdown first writes its resident pages to the warm-up file.
+ *
+ * A handle from attachBufferPool only detaches: the pages of its file are
+ * written back and evicted and the file is closed, unless another handle
+ * still has the file open.
+ */
+RC shutdownBufferPool(BM_BufferPool *const bm)
+{
+    PoolHandle *handle = (PoolHandle *)bm->mgmtData;
+    BufferPoolMetadata *metadata = handle->pool;
+    RC rc;
+    int i;
+
+    if (!handle->ownsPool)
+    {
+        rc = unregisterFile(metadata, handle->fileId);
+        if (rc != RC_OK)
+            return rc;
+
+        pthread_mutex_lock(&metadata->filesLatch);
+        metadata->numAttached--;
+        pthread_mutex_unlock(&metadata->filesLatch);
+
+        free(handle);
+        bm->mgmtData = NULL;
+        return RC_OK;
+    }
+
+    pthread_mutex_lock(&metadata->filesLatch);
+    bool inUse = metadata->numAttached > 0;
+    pthread_mutex_unlock(&metadata->filesLatch);
+    if (inUse)
+        return RC_BUFFER_POOL_IN_USE;
+
+    // The helper threads pin pages while they work, so stop them first
+    stopBackgroundWriter(bm);
+    stopEvictor(bm);
+    stopCheckpoint(metadata);
+    stopPrefetcher(metadata);
+    stopPageTrace(bm);
+
+    // Check for pinned pages; retired frames keep the pin of their claim
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        if (!ATOMIC_LOAD(&frame->retired) && ATOMIC_LOAD(&frame->pinCount) > 0)
+            return RC_PINNED_PAGES_IN_BUFFER;
+    }
+
+    // Remember the resident pages for the next start; if this fails the
+    // next start is merely cold
+    if (handle->warmFile != NULL)
+        dumpBufferPool(bm, handle->warmFile);
+
+    // Write all dirty pages to disk and close the file
+    if (handle->fileId != NO_FILE)
+    {
+        rc = unregisterFile(metadata, handle->fileId);
+        if (rc != RC_OK)
+            return rc;
+    }
+
+    destroyPool(metadata);
+    free(handle->warmFile);
+    free(handle);
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
+
+/**
+ * Writes all dirty pages from buffer pool to disk.
+ *
+ * @param bm Buffer pool handle containing pages to flush
+ * @return RC_OK on successful flush, the storage manager's error otherwise
+ *
+ * Iterates through all frames and writes dirty, unpinned pages to disk.
+ * Each page is held only for the duration of its own write, so other
+ * threads keep pinning pages while the pool is flushed. Skips pinned pages
+ * even if dirty to maintain consistency. The caller waits for every
+ * write; startCheckpoint writes the pages in the background instead. A
+ * handle bound to a file flushes only that file's pages, a bare shared
+ * pool flushes every file.
+ */
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc;
+    int i;
+
+    // Write dirty and unpinned pages to disk
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+    {
+        flushFrame(metadata, i, fileOf(bm), &rc);
+        if (rc != RC_OK)
+            return rc;
+    }
+    return RC_OK;
+}
+
+/**
+ * Changes the number of frames of a buffer pool while it is in use.
+ *
+ * @param bm Buffer pool handle
+ * @param newNumPages Number of frames the pool should have
+ * @return RC_OK on success, RC_INVALID_PARAMETER for a bad size,
+ *         RC_MEMORY_ALLOCATION_ERROR if the pool cannot grow, or
+ *         RC_PINNED_PAGES_IN_BUFFER if too many pages are pinned to shrink
+ *
+ * Growing first brings back frames retired by an earlier shrink, then maps
+ * new extents; the new frames are used by the next misses right away.
+ * Shrinking evicts victims chosen by the pool's replacement strategy, one
+ * at a time and exactly as a miss would, and retires their frames; the
+ * memory of a retired frame is returned to the operating system. Concurrent
+ * pins are only held up as by any other miss. If pinned pages keep the
+ * pool from shrinking far enough, the frames retired so far stay retired.
+ * bm->numPages is updated to the resulting size; other handles attached
+ * to the same pool keep their old value.
+ */
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc = RC_OK;
+    int i;
+
+    if (newNumPages <= 0)
+        return RC_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&metadata->resizeLatch);
+    int totalFrames = ATOMIC_LOAD(&metadata->totalFrames);
+    int numFrames = totalFrames - metadata->numRetired;
+
+    // Bring back retired frames; they are empty and pinned by their claim
+    for (i = 0; i < totalFrames && numFrames < newNumPages && metadata->numRetired > 0; i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        if (ATOMIC_LOAD(&frame->retired))
+        {
+            ATOMIC_STORE(&frame->retired, false);
+            releaseFrame(frame);
+            metadata->numRetired--;
+            numFrames++;
+        }
+    }
+
+    // Add frames at the end of the pool
+    if (numFrames < newNumPages)
+    {
+        int newTotal = totalFrames + newNumPages - numFrames;
+        rc = allocateFrames(metadata, newTotal);
+        if (rc == RC_OK)
+            rc = growPageTable(metadata, newTotal);
+        if (rc == RC_OK)
+        {
+            pthread_mutex_lock(&metadata->replLatch);
+            ATOMIC_STORE(&metadata->totalFrames, newTotal);
+            pthread_mutex_unlock(&metadata->replLatch);
+            numFrames = newNumPages;
+        }
+    }
+
+    // Shrink by evicting victims and keeping their frames claimed
+    while (numFrames > newNumPages)
+    {
+        int index;
+        rc = acquireFrame(metadata, &index);
+        if (rc != RC_OK)
+        {
+            if (rc == RC_ERROR)
+                rc = RC_PINNED_PAGES_IN_BUFFER; // Every remaining frame is pinned
+            break;
+        }
+        Frame *frame = frameAt(metadata, index);
+        ATOMIC_STORE(&frame->retired, true);
+        // Memory of explicit huge pages can only be given back whole
+        bumpVersion(frame);
+        if (metadata->arenaPages[index >> BM_EXTENT_SHIFT] != BM_HUGE_PAGES_EXPLICIT)
+            madvise(frame->data, PAGE_SIZE, MADV_DONTNEED);
+        bumpVersion(frame);
+        metadata->numRetired++;
+        numFrames--;
+    }
+
+    bm->numPages = numFrames;
+    pthread_mutex_unlock(&metadata->resizeLatch);
+
+    return rc;
+}
+
+/**
+ * Marks a page in the buffer pool as dirty.
+ *
+ * @param bm Buffer pool handle
+ * @param page Page handle of page to mark
+ * @return RC_OK if page found and marked, RC_ERROR if page not in pool
+ *
+ * Sets the dirty flag for the specified page indicating it needs to be
+ * written to disk before replacement. Essential for maintaining data
+ * consistency between memory and disk.
+ */
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // Get metadata structure
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    PageTablePartition *part = partitionFor(metadata, fileId, page->pageNum);
+
+    // Find the page in buffer pool
+    pthread_mutex_lock(&part->latch);
+    int index = findFrame(metadata, part, fileId, page->pageNum);
+
+    // If page found, mark it as dirty; the first change since the page
+    // was last written starts its recovery window
+    if (index != NO_FRAME)
+    {
+        Frame *frame = frameAt(metadata, index);
+        bool clean = false;
+        if (ATOMIC_CAS(&frame->isDirty, &clean, true))
+            RELAXED_STORE(&frame->dirtiedAt, nowNanos());
+    }
+    pthread_mutex_unlock(&part->latch);
+
+    if (index != NO_FRAME)
+        traceAccess(metadata, fileId, page->pageNum, BM_TRACE_DIRTY);
+    return (index != NO_FRAME) ? RC_OK : RC_ERROR;
+}
+
+/**
+ * Decrements the pin count of a page.
+ *
+ * @param bm Buffer pool handle
+ * @param page Page handle of page to unpin
+ * @return RC_OK on success, RC_ERROR if page not found or already unpinned
+ *
+ * Reduces pin count indicating one fewer client is using the page.
+ * Pages with zero pin count become candidates for replacement.
+ * Prevents unpinning already unpinned pages.
+ */
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // Get metadata structure
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    PageTablePartition *part = partitionFor(metadata, fileId, page->pageNum);
+    RC rc = RC_ERROR;
+
+    // Find the page in buffer pool
+    pthread_mutex_lock(&part->latch);
+    int index = findFrame(metadata, part, fileId, page->pageNum);
+
+    // Decrement pin count if page is pinned
+    if (index != NO_FRAME && ATOMIC_LOAD(&frameAt(metadata, index)->pinCount) > 0)
+    {
+        ATOMIC_DEC(&frameAt(metadata, index)->pinCount);
+        rc = RC_OK;
+    }
+    pthread_mutex_unlock(&part->latch);
+
+    if (rc == RC_OK)
+        traceAccess(metadata, fileId, page->pageNum, BM_TRACE_UNPIN);
+    return rc;
+}
+
+/**
+ * Immediately writes a page to disk.
+ *
+ * @param bm Buffer pool handle
+ * @param page Page handle of page to force
+ * @return RC_OK on successful write, RC_ERROR if page not found
+ *
+ * Writes the page content regardless of dirty flag and updates write
+ * statistics. The page is held pinned during the write so it cannot be
+ * replaced underneath. Useful for immediate persistence of critical data
+ * changes.
+ */
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // Get metadata structure
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    PageTablePartition *part = partitionFor(metadata, fileId, page->pageNum);
+
+    // Find the page in buffer pool
+    pthread_mutex_lock(&part->latch);
+    int index = findFrame(metadata, part, fileId, page->pageNum);
+    if (index == NO_FRAME || !pinMappedFrame(metadata, part, index, fileId, page->pageNum))
+    {
+        pthread_mutex_unlock(&part->latch);
+        return RC_ERROR;
+    }
+    pthread_mutex_unlock(&part->latch);
+
+    // Write page and update its state
+    Frame *frame = frameAt(metadata, index);
+    ATOMIC_STORE(&frame->isDirty, false);
+    RC rc = writePageData(metadata, fileId, page->pageNum, frame->data);
+    if (rc != RC_OK)
+        ATOMIC_STORE(&frame->isDirty, true);
+    else
+        COUNT_EVENT(metadata, fileId, forcedWrites);
+    ATOMIC_DEC(&frame->pinCount);
+
+    return rc;
+}
+
+/**
+ * Sets the replacement hint of a page in the buffer pool.
+ *
+ * @param bm Buffer pool handle
+ * @param pageNum Page to hint
+ * @param hint BM_HINT_HOT, BM_HINT_COLD, or BM_HINT_NONE to clear the hint
+ * @return RC_OK if the page was found, RC_ERROR if it is not in the pool,
+ *         RC_INVALID_PARAMETER for an unknown hint
+ *
+ * Every replacement strategy evicts cold pages before all others and hot
+ * pages only when nothing else can be evicted, so structural pages such
+ * as a table's header page or an index root survive scans that sweep the
+ * pool. Among pages of the same hint the strategy decides as usual. The
+ * hint belongs to the resident copy of the page and is dropped when the
+ * page is evicted, so callers set it again after pinning the page.
+ */
+RC setPageHint(BM_BufferPool *const bm, const PageNumber pageNum, const BM_PageHint hint)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+
+    if (hint != BM_HINT_NONE && hint != BM_HINT_HOT && hint != BM_HINT_COLD)
+        return RC_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&part->latch);
+    int index = findFrame(metadata, part, fileId, pageNum);
+    if (index != NO_FRAME)
+        setFrameHint(metadata, frameAt(metadata, index), hint);
+    pthread_mutex_unlock(&part->latch);
+
+    return (index != NO_FRAME) ? RC_OK : RC_ERROR;
+}
+
+/**
+ * Pins a page into the buffer pool, loading it from disk if necessary.
+ *
+ * @param bm Buffer pool handle
+ * @param page Page handle to store the requested page
+ * @param pageNum Page number to be pinned
+ * @return RC_OK on success, RC_ERROR if every frame is pinned,
+ *         RC_FILE_HANDLE_NOT_INIT on a handle without a page file, or the
+ *         storage manager's error if the page cannot be read
+ *
+ * This function first checks if the page is already in the buffer pool.
+ * If present, it increments the pin count and updates metadata.
+ * If not, it obtains a frame (a free one or a victim chosen by the
+ * replacement strategy), publishes the page in the page table as being
+ * loaded, and reads it with no latch held. Concurrent pins of a page that
+ * is being loaded, or prefetched, wait for that single read instead of
+ * issuing their own.
+ */
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
+           const PageNumber pageNum)
+{
+    // Retrieve buffer pool metadata
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int index;
+
+    if (fileOf(bm) == NO_FILE)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (pageNum < 0)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    RC rc = loadPage(metadata, fileOf(bm), pageNum, true, &index);
+    if (rc != RC_OK)
+        return rc;
+    traceAccess(metadata, fileOf(bm), pageNum, BM_TRACE_PIN);
+
+    // Assign the page handle
+    page->pageNum = pageNum;
+    page->data = frameAt(metadata, index)->data;
+    return RC_OK;
+}
+
+// A page requested from pinPages or unpinPages and its place in the request
+typedef struct BatchEntry
+{
+    PageNumber pageNum;
+    int slot;      // Index into the caller's arrays
+    int partition; // Page-table partition of the page
+} BatchEntry;
+
+/**
+ * Orders batch entries by partition and then by page number
+ */
+static int compareByPartition(const void *a, const void *b)
+{
+    const BatchEntry *x = (const BatchEntry *)a, *y = (const BatchEntry *)b;
+    if (x->partition != y->partition)
+        return (x->partition > y->partition) - (x->partition < y->partition);
+    return (x->pageNum > y->pageNum) - (x->pageNum < y->pageNum);
+}
+
+/**
+ * Orders batch entries by page number
+ */
+static int compareByPage(const void *a, const void *b)
+{
+    const BatchEntry *x = (const BatchEntry *)a, *y = (const BatchEntry *)b;
+    if (x->pageNum != y->pageNum)
+        return (x->pageNum > y->pageNum) - (x->pageNum < y->pageNum);
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+/**
+ * Fills the entries of a batch and sorts them by partition
+ */
+static BatchEntry *makeBatch(int fileId, const PageNumber *pageNums, int n)
+{
+    BatchEntry *batch = (BatchEntry *)malloc(sizeof(BatchEntry) * n);
+    int i;
+
+    if (batch == NULL)
+        return NULL;
+    for (i = 0; i < n; i++)
+    {
+        batch[i].pageNum = pageNums[i];
+        batch[i].slot = i;
+        batch[i].partition = pageHash(fileId, pageNums[i]) % BM_PAGE_TABLE_PARTITIONS;
+    }
+    qsort(batch, n, sizeof(BatchEntry), compareByPartition);
+    return batch;
+}
+
+/**
+ * Loads the missed pages of a batch, sorted by page number and each page
+ * once. Frames for all of them are obtained in one pass, and each run of
+ * adjacent pages is read with one vectored read. A page gets the frame,
+ * still pinned, of the first batch entry asking for it in frames[].
+ */
+static RC loadMisses(BufferPoolMetadata *metadata, int fileId, BatchEntry *misses, int numMisses,
+                     int *frames)
+{
+    int *missFrames = (int *)malloc(sizeof(int) * (numMisses + 1));
+    SM_PageHandle *data = (SM_PageHandle *)malloc(sizeof(SM_PageHandle) * (numMisses + 1));
+    int acquired = 0, i, j, k;
+    RC rc = RC_MEMORY_ALLOCATION_ERROR;
+
+    if (missFrames != NULL && data != NULL)
+        rc = acquireFrames(metadata, numMisses, missFrames, &acquired);
+    if (rc != RC_OK)
+    {
+        for (i = 0; i < acquired; i++)
+            releaseFrame(frameAt(metadata, missFrames[i]));
+        free(missFrames);
+        free(data);
+        return rc;
+    }
+
+    // Publish the pages as being loaded; pages loaded by another thread
+    // meanwhile are pinned later through the page table
+    for (i = 0; i < numMisses; i++)
+    {
+        PageTablePartition *part = &metadata->partitions[misses[i].partition];
+        Frame *frame = frameAt(metadata, missFrames[i]);
+
+        pthread_mutex_lock(&part->latch);
+        if (findFrame(metadata, part, fileId, misses[i].pageNum) != NO_FRAME)
+        {
+            releaseFrame(frame);
+            missFrames[i] = NO_FRAME;
+        }
+        else
+        {
+            bumpVersion(frame);
+            ATOMIC_STORE(&frame->fileId, fileId);
+            ATOMIC_STORE(&frame->pageNum, misses[i].pageNum);
+            ATOMIC_STORE(&frame->ioInProgress, true);
+            ATOMIC_STORE(&frame->isDirty, false);
+            RELAXED_STORE(&frame->accessCount, 1);
+            RELAXED_STORE(&frame->lastAccessed, ATOMIC_INC(&metadata->globalTimer));
+            insertFrame(metadata, part, missFrames[i]);
+        }
+        pthread_mutex_unlock(&part->latch);
+    }
+
+    // Read each run of adjacent published pages at once
+    for (i = 0; i < numMisses; i = j)
+    {
+        if (missFrames[i] == NO_FRAME)
+        {
+            j = i + 1;
+            continue;
+        }
+        for (j = i; j < numMisses && missFrames[j] != NO_FRAME &&
+                    misses[j].pageNum == misses[i].pageNum + (j - i);
+             j++)
+            data[j - i] = frameAt(metadata, missFrames[j])->data;
+
+        RC readRc = readPageFrames(metadata, fileId, misses[i].pageNum, j - i, data);
+        if (readRc != RC_OK)
+            rc = readRc;
+
+        for (k = i; k < j; k++)
+        {
+            PageTablePartition *part = &metadata->partitions[misses[k].partition];
+            Frame *frame = frameAt(metadata, missFrames[k]);
+
+            COUNT_EVENT(metadata, fileId, misses);
+            pthread_mutex_lock(&part->latch);
+            ATOMIC_STORE(&frame->ioInProgress, false);
+            bumpVersion(frame);
+            if (readRc != RC_OK)
+            {
+                removeFrame(metadata, part, missFrames[k]);
+                ATOMIC_STORE(&frame->pageNum, NO_PAGE);
+                releaseFrame(frame);
+            }
+            else
+            {
+                frames[misses[k].slot] = missFrames[k];
+            }
+            pthread_cond_broadcast(&part->ioDone);
+            pthread_mutex_unlock(&part->latch);
+        }
+    }
+
+    free(missFrames);
+    free(data);
+    return rc;
+}
+
+/**
+ * Pins several pages of the file in one call.
+ *
+ * @param bm Buffer pool handle
+ * @param pages Page handles receiving the pages, one per page number
+ * @param pageNums Page numbers to pin, in any order, repeats allowed
+ * @param n Number of pages
+ * @return RC_OK if every page was pinned, otherwise the error of pinPage;
+ *         on error no page of the request stays pinned
+ *
+ * Behaves like n calls of pinPage, but groups the work: the page table is
+ * searched partition by partition with each partition latch taken once,
+ * frames for all missed pages are obtained in one pass over the
+ * replacement latch, and the misses are read sorted by page number, each
+ * run of adjacent pages with one vectored read. Range scans and bulk loads
+ * pay the per-page overhead once per batch instead of once per page. All
+ * pages of a request are pinned at the same time, so n must not exceed
+ * the number of frames that are not pinned by others.
+ */
+RC pinPages(BM_BufferPool *const bm, BM_PageHandle *const pages, const PageNumber *pageNums,
+            const int n)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    int numMisses = 0, i, j;
+    RC rc = RC_OK;
+
+    if (fileId == NO_FILE)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (n < 0)
+        return RC_INVALID_PARAMETER;
+    for (i = 0; i < n; i++)
+        if (pageNums[i] < 0)
+            return RC_READ_NON_EXISTING_PAGE;
+    if (n == 0)
+        return RC_OK;
+
+    BatchEntry *batch = makeBatch(fileId, pageNums, n);
+    int *frames = (int *)malloc(sizeof(int) * n);
+    if (batch == NULL || frames == NULL)
+    {
+        free(batch);
+        free(frames);
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+
+    // Pin the resident pages, one latch acquisition per partition
+    for (i = 0; i < n; i = j)
+    {
+        PageTablePartition *part = &metadata->partitions[batch[i].partition];
+        pthread_mutex_lock(&part->latch);
+        for (j = i; j < n && batch[j].partition == batch[i].partition; j++)
+        {
+            int index = findFrame(metadata, part, fileId, batch[j].pageNum);
+            frames[batch[j].slot] = NO_FRAME;
+            if (index != NO_FRAME && pinMappedFrame(metadata, part, index, fileId, batch[j].pageNum))
+            {
+                COUNT_EVENT(metadata, fileId, hits);
+                touchFrame(metadata, frameAt(metadata, index));
+                frames[batch[j].slot] = index;
+            }
+        }
+        pthread_mutex_unlock(&part->latch);
+    }
+
+    // Load the missed pages, each distinct page once
+    qsort(batch, n, sizeof(BatchEntry), compareByPage);
+    for (i = 0; i < n; i++)
+    {
+        if (frames[batch[i].slot] == NO_FRAME &&
+            (numMisses == 0 || batch[numMisses - 1].pageNum != batch[i].pageNum))
+            batch[numMisses++] = batch[i];
+    }
+    if (numMisses > 0)
+        rc = loadMisses(metadata, fileId, batch, numMisses, frames);
+
+    // Repeated pages, and pages another thread loaded meanwhile, take the
+    // normal path, which now finds them resident
+    for (i = 0; rc == RC_OK && i < n; i++)
+    {
+        if (frames[i] == NO_FRAME)
+            rc = loadPage(metadata, fileId, pageNums[i], true, &frames[i]);
+    }
+
+    if (rc != RC_OK)
+    {
+        for (i = 0; i < n; i++)
+            if (frames[i] != NO_FRAME)
+                ATOMIC_DEC(&frameAt(metadata, frames[i])->pinCount);
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+        {
+            pages[i].pageNum = pageNums[i];
+            pages[i].data = frameAt(metadata, frames[i])->data;
+            traceAccess(metadata, fileId, pageNums[i], BM_TRACE_PIN);
+        }
+    }
+
+    free(batch);
+    free(frames);
+    return rc;
+}
+
+/**
+ * Unpins several pages in one call.
+ *
+ * @param bm Buffer pool handle
+ * @param pages Page handles of the pages to unpin
+ * @param n Number of pages
+ * @return RC_OK on success, RC_ERROR if any page was not pinned
+ *
+ * Behaves like n calls of unpinPage with each page-table partition latch
+ * taken once. Pages that are not pinned are skipped; the others are
+ * unpinned even then.
+ */
+RC unpinPages(BM_BufferPool *const bm, BM_PageHandle *const pages, const int n)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    RC rc = RC_OK;
+    int i, j;
+
+    if (n <= 0)
+        return (n == 0) ? RC_OK : RC_INVALID_PARAMETER;
+
+    PageNumber *pageNums = (PageNumber *)malloc(sizeof(PageNumber) * n);
+    if (pageNums == NULL)
+        return RC_MEMORY_ALLOCATION_ERROR;
+    for (i = 0; i < n; i++)
+        pageNums[i] = pages[i].pageNum;
+    BatchEntry *batch = makeBatch(fileId, pageNums, n);
+    free(pageNums);
+    if (batch == NULL)
+        return RC_MEMORY_ALLOCATION_ERROR;
+
+    for (i = 0; i < n; i = j)
+    {
+        PageTablePartition *part = &metadata->partitions[batch[i].partition];
+        pthread_mutex_lock(&part->latch);
+        for (j = i; j < n && batch[j].partition == batch[i].partition; j++)
+        {
+            int index = findFrame(metadata, part, fileId, batch[j].pageNum);
+            if (index != NO_FRAME && ATOMIC_LOAD(&frameAt(metadata, index)->pinCount) > 0)
+            {
+                ATOMIC_DEC(&frameAt(metadata, index)->pinCount);
+                traceAccess(metadata, fileId, batch[j].pageNum, BM_TRACE_UNPIN);
+            }
+            else
+            {
+                rc = RC_ERROR;
+            }
+        }
+        pthread_mutex_unlock(&part->latch);
+    }
+
+    free(batch);
+    return rc;
+}
+
+/**
+ * Finds the frame whose data lies at an address; the extents never move,
+ * so no latch is needed. Returns NULL for an address outside the pool.
+ */
+static Frame *frameOfData(BufferPoolMetadata *metadata, char *data)
+{
+    int numExtents = ATOMIC_LOAD(&metadata->numExtents);
+    int i;
+
+    for (i = 0; data != NULL && i < numExtents; i++)
+    {
+        char *arena = metadata->arenas[i];
+        if (data >= arena && data < arena + BM_ARENA_SIZE)
+            return &metadata->extents[i][(data - arena) / PAGE_SIZE];
+    }
+    return NULL;
+}
+
+/**
+ * Finds the frame behind a page handle; NULL unless the frame holds the
+ * handle's page and is pinned
+ */
+static Frame *pinnedFrameOf(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    Frame *frame = frameOfData(poolOf(bm), page->data);
+
+    if (frame != NULL && holdsPage(frame, fileOf(bm), page->pageNum) &&
+        ATOMIC_LOAD(&frame->pinCount) > 0)
+        return frame;
+    return NULL;
+}
+
+/**
+ * Checks whether a latch word keeps a request from being granted
+ */
+static bool latchBlocks(unsigned int word, bool exclusive)
+{
+    if (exclusive)
+        return (word & (LATCH_EXCLUSIVE | LATCH_SHARED_MASK)) != 0;
+    return (word & (LATCH_EXCLUSIVE | LATCH_WRITER_WAITING)) != 0;
+}
+
+/**
+ * Tries to take a content latch with compare-and-swap only
+ */
+static bool tryLatch(Frame *frame, bool exclusive)
+{
+    unsigned int word = ATOMIC_LOAD(&frame->latch);
+
+    while (!latchBlocks(word, exclusive))
+    {
+        unsigned int desired = exclusive ? (word | LATCH_EXCLUSIVE) : (word + 1);
+        if (ATOMIC_CAS(&frame->latch, &word, desired))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Takes the content latch of a frame pinned by the caller, sleeping while
+ * it is held in a conflicting mode. Sleepers announce themselves in the
+ * latch word under the partition latch, so a release that sees them
+ * cannot miss a sleeper.
+ */
+static void latchFrame(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, Frame *frame, bool exclusive)
+{
+    // Uncontended: one compare-and-swap
+    if (!tryLatch(frame, exclusive))
+    {
+        PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+        unsigned int flags = LATCH_SLEEPERS | (exclusive ? LATCH_WRITER_WAITING : 0);
+
+        pthread_mutex_lock(&part->latch);
+        while (!tryLatch(frame, exclusive))
+        {
+            // Sleep only if the latch was still taken when the flags were set
+            if (latchBlocks(ATOMIC_OR(&frame->latch, flags) | flags, exclusive))
+                pthread_cond_wait(&part->latchFree, &part->latch);
+        }
+        pthread_mutex_unlock(&part->latch);
+    }
+
+    if (exclusive)
+        bumpVersion(frame);
+}
+
+/**
+ * Releases the exclusive latch of a frame or one shared hold; returns
+ * false if the frame is not latched
+ */
+static bool unlatchFrame(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, Frame *frame)
+{
+    unsigned int word, desired;
+
+    // Publish the new contents to optimistic readers before letting go
+    word = ATOMIC_LOAD(&frame->latch);
+    if (word & LATCH_EXCLUSIVE)
+        bumpVersion(frame);
+    do
+    {
+        if (word & LATCH_EXCLUSIVE)
+            desired = word & ~LATCH_EXCLUSIVE;
+        else if (word & LATCH_SHARED_MASK)
+            desired = word - 1;
+        else
+            return false;
+    } while (!ATOMIC_CAS(&frame->latch, &word, desired));
+
+    // Wake the sleepers; the ones still blocked set the flags again
+    if (desired & LATCH_SLEEPERS)
+    {
+        PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+        pthread_mutex_lock(&part->latch);
+        ATOMIC_AND(&frame->latch, ~(LATCH_SLEEPERS | LATCH_WRITER_WAITING));
+        pthread_cond_broadcast(&part->latchFree);
+        pthread_mutex_unlock(&part->latch);
+    }
+    return true;
+}
+
+/**
+ * Takes the content latch of a pinned page
+ */
+static RC latchPage(BM_BufferPool *const bm, BM_PageHandle *const page, bool exclusive)
+{
+    Frame *frame = pinnedFrameOf(bm, page);
+
+    if (frame == NULL)
+        return RC_ERROR;
+
+    latchFrame(poolOf(bm), fileOf(bm), page->pageNum, frame, exclusive);
+    return RC_OK;
+}
+
+/**
+ * Takes the shared content latch of a pinned page.
+ *
+ * @param bm Buffer pool handle
+ * @param page Handle of a page pinned by the caller
+ * @return RC_OK once the latch is held, RC_ERROR if the page is not pinned
+ *
+ * Pins only keep a page in its frame; content latches order the access to
+ * the page's data. Any number of threads can hold the shared latch at the
+ * same time, which excludes exclusive holders, so the page does not change
+ * while it is read. Taking a free latch costs one compare-and-swap; a
+ * caller that has to wait sleeps until the latch is released. A waiting
+ * exclusive request holds off new shared ones, so writers are not starved.
+ * Latches are not recursive and must be released with unlatchPage before
+ * the page is unpinned.
+ */
+RC latchPageShared(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    return latchPage(bm, page, false);
+}
+
+/**
+ * Takes the exclusive content latch of a pinned page.
+ *
+ * @param bm Buffer pool handle
+ * @param page Handle of a page pinned by the caller
+ * @return RC_OK once the latch is held, RC_ERROR if the page is not pinned
+ *
+ * The exclusive latch excludes every other holder, shared or exclusive,
+ * so the caller can modify the page without readers seeing a half-written
+ * record. Taking and releasing it bumps the frame's version, which lets
+ * readPageOptimistic detect the change. See latchPageShared.
+ */
+RC latchPageExclusive(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    return latchPage(bm, page, true);
+}
+
+/**
+ * Releases the content latch the caller holds on a page.
+ *
+ * @param bm Buffer pool handle
+ * @param page Handle of a pinned page latched by the caller
+ * @return RC_OK on success, RC_ERROR if the page is not pinned or latched
+ *
+ * Releases the exclusive latch if it is held, otherwise one shared hold.
+ * Sleeping requests are woken only if there are any.
+ */
+RC unlatchPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    Frame *frame = pinnedFrameOf(bm, page);
+
+    if (frame == NULL || !unlatchFrame(poolOf(bm), fileOf(bm), page->pageNum, frame))
+        return RC_ERROR;
+    return RC_OK;
+}
+
+/**
+ * Copies bytes of a frame that a writer may be changing at the same time.
+ * The copy is validated through the frame's version afterwards, so the
+ * race is intended and hidden from the thread sanitizer, whose memcpy
+ * interceptor would report it.
+ */
+#ifdef __SANITIZE_THREAD__
+__attribute__((no_sanitize_thread))
+static void copyUnlatched(char *dest, const char *src, int length)
+{
+    const volatile char *from = src;
+    int i;
+    for (i = 0; i < length; i++)
+        dest[i] = from[i];
+}
+#else
+static void copyUnlatched(char *dest, const char *src, int length)
+{
+    memcpy(dest, src, length);
+}
+#endif
+
+/**
+ * Copies part of a page without pinning or latching it, if the frame still
+ * holds the page and no writer changed it during the copy
+ */
+static bool tryReadOptimistic(Frame *frame, int fileId, PageNumber pageNum, int offset,
+                              int length, char *dest)
+{
+    unsigned int version = ATOMIC_LOAD(&frame->version);
+
+    if ((version & 1) || !holdsPage(frame, fileId, pageNum) || ATOMIC_LOAD(&frame->ioInProgress))
+        return false;
+    copyUnlatched(dest, frame->data + offset, length);
+
+    // Keep the copy from being moved after the second version check
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return RELAXED_LOAD(&frame->version) == version && holdsPage(frame, fileId, pageNum);
+}
+
+/**
+ * Reads part of a page optimistically, without pinning it.
+ *
+ * @param bm Buffer pool handle
+ * @param page Handle remembering where the page was found last time; set
+ *        data to NULL before the first call
+ * @param pageNum Page to read
+ * @param offset Offset of the first byte to read within the page
+ * @param length Number of bytes to read
+ * @param dest Buffer receiving the bytes
+ * @return RC_OK on success, RC_INVALID_PARAMETER for a range outside the
+ *         page, otherwise the error of pinPage
+ *
+ * If the handle still points at the frame holding the page, the bytes are
+ * copied without touching the pin count or any latch: the frame's version
+ * is read before and after the copy, and the copy is retried if the
+ * version changed in between. Hot pages such as table headers and index
+ * roots are then read by many threads without writing to a shared cache
+ * line. If the page moved, or keeps changing, the page is pinned and
+ * copied under its shared latch instead, which also updates the handle for
+ * the next call. The handle never holds a pin between calls. Writers must
+ * modify pages under latchPageExclusive for optimistic readers to see
+ * consistent copies.
+ */
+RC readPageOptimistic(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum,
+                      const int offset, const int length, char *dest)
+{
+    int fileId = fileOf(bm);
+    int attempt;
+
+    if (offset < 0 || length < 0 || offset + length > PAGE_SIZE)
+        return RC_INVALID_PARAMETER;
+
+    // Fast path: the frame the handle remembers
+    Frame *frame = (page->pageNum == pageNum) ? frameOfData(poolOf(bm), page->data) : NULL;
+    for (attempt = 0; frame != NULL && attempt < BM_OPTIMISTIC_RETRIES; attempt++)
+    {
+        if (tryReadOptimistic(frame, fileId, pageNum, offset, length, dest))
+            return RC_OK;
+        if (!holdsPage(frame, fileId, pageNum))
+            break;
+    }
+
+    // Slow path: pin the page and copy it under the shared latch
+    RC rc = pinPage(bm, page, pageNum);
+    if (rc != RC_OK)
+        return rc;
+    rc = latchPageShared(bm, page);
+    if (rc != RC_OK)
+    {
+        unpinPage(bm, page);
+        return rc;
+    }
+    memcpy(dest, page->data + offset, length);
+    rc = unlatchPage(bm, page);
+    RC unpinned = unpinPage(bm, page);
+    return (rc != RC_OK) ? rc : unpinned;
+}
+
+/**
+ * Body of the prefetch thread: loads queued pages without pinning them
+ */
+static void *prefetcher(void *arg)
+{
+    BufferPoolMetadata *metadata = (BufferPoolMetadata *)arg;
+    int index;
+
+    pthread_mutex_lock(&metadata->prefetchLatch);
+    while (true)
+    {
+        while (metadata->prefetchCount == 0 && !metadata->prefetchStop)
+            pthread_cond_wait(&metadata->prefetchWake, &metadata->prefetchLatch);
+        if (metadata->prefetchStop)
+            break;
+
+        // Take the oldest request off the queue
+        PageRequest request = metadata->prefetchQueue[metadata->prefetchHead];
+        metadata->prefetchHead = (metadata->prefetchHead + 1) % BM_PREFETCH_QUEUE_SIZE;
+        metadata->prefetchCount--;
+        pthread_mutex_unlock(&metadata->prefetchLatch);
+
+        // Failures are ignored, a later pinPage simply misses
+        loadPage(metadata, request.fileId, request.pageNum, false, &index);
+
+        pthread_mutex_lock(&metadata->prefetchLatch);
+    }
+    pthread_mutex_unlock(&metadata->prefetchLatch);
+
+    return NULL;
+}
+
+/**
+ * Stops the prefetch thread and drops requests that are still queued
+ */
+static void stopPrefetcher(BufferPoolMetadata *metadata)
+{
+    pthread_mutex_lock(&metadata->prefetchLatch);
+    if (!metadata->prefetchRunning)
+    {
+        pthread_mutex_unlock(&metadata->prefetchLatch);
+        return;
+    }
+    metadata->prefetchStop = true;
+    pthread_cond_signal(&metadata->prefetchWake);
+    pthread_mutex_unlock(&metadata->prefetchLatch);
+
+    pthread_join(metadata->prefetchThread, NULL);
+    metadata->prefetchRunning = false;
+    metadata->prefetchCount = 0;
+}
+
+/**
+ * Asks the buffer pool to load a page in the background.
+ *
+ * @param bm Buffer pool handle
+ * @param pageNum Page number that will be pinned soon
+ * @return RC_OK if the page is resident or queued, RC_ERROR if the
+ *         prefetch queue is full or the prefetch thread cannot be started
+ *
+ * The page is read by the pool's prefetch thread into a free or evictable
+ * frame and left unpinned, so a later pinPage hits. A pinPage issued while
+ * the read is still in flight waits for it. Prefetching is advisory: if
+ * every frame is pinned the request is dropped.
+ */
+RC prefetchPage(BM_BufferPool *const bm, const PageNumber pageNum)
+{
+    return prefetchPages(bm, pageNum, 1);
+}
+
+/**
+ * Asks the buffer pool to load a range of pages in the background.
+ *
+ * @param bm Buffer pool handle
+ * @param start First page number of the range
+ * @param count Number of consecutive pages
+ * @return RC_OK if every page is resident or queued, RC_ERROR if the
+ *         prefetch queue filled up (the remaining pages are not queued)
+ *
+ * Pages are loaded in ascending order. Callers should keep the range well
+ * below the pool size, or the prefetched pages evict each other.
+ */
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber start, const int count)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    RC rc = RC_OK;
+    int i;
+
+    if (fileId == NO_FILE)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (start < 0 || count < 0)
+        return RC_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&metadata->prefetchLatch);
+
+    // Start the prefetch thread on first use
+    if (!metadata->prefetchRunning)
+    {
+        metadata->prefetchStop = false;
+        if (pthread_create(&metadata->prefetchThread, NULL, prefetcher, metadata) != 0)
+        {
+            pthread_mutex_unlock(&metadata->prefetchLatch);
+            return RC_ERROR;
+        }
+        metadata->prefetchRunning = true;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        PageNumber pageNum = start + i;
+
+        // Skip pages that are already resident or being loaded
+        PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+        pthread_mutex_lock(&part->latch);
+        bool resident = (findFrame(metadata, part, fileId, pageNum) != NO_FRAME);
+        pthread_mutex_unlock(&part->latch);
+        if (resident)
+            continue;
+
+        if (metadata->prefetchCount == BM_PREFETCH_QUEUE_SIZE)
+        {
+            rc = RC_ERROR;
+            break;
+        }
+        PageRequest *request = &metadata->prefetchQueue[(metadata->prefetchHead + metadata->prefetchCount) % BM_PREFETCH_QUEUE_SIZE];
+        request->fileId = fileId;
+        request->pageNum = pageNum;
+        metadata->prefetchCount++;
+    }
+
+    pthread_cond_signal(&metadata->prefetchWake);
+    pthread_mutex_unlock(&metadata->prefetchLatch);
+
+    return rc;
+}
+
+/**
+ * Collects up to max dirty, unpinned frames closest to eviction, in the
+ * order the pool's strategy would evict them. Returns how many were found.
+ */
+static int findCleaningCandidates(BufferPoolMetadata *metadata, int *candidates, long *keys, int max)
+{
+    int found = 0;
+    int i, j;
+
+    if (metadata->strategy == RS_FIFO || metadata->strategy == RS_CLOCK)
+    {
+        // Look ahead of the hand, where the next victims will come from
+        pthread_mutex_lock(&metadata->replLatch);
+        int hand = (metadata->strategy == RS_FIFO) ? metadata->fifoHand : metadata->clockHand;
+        pthread_mutex_unlock(&metadata->replLatch);
+
+        int totalFrames = ATOMIC_LOAD(&metadata->totalFrames);
+        for (i = 0; i < totalFrames && found < max; i++)
+        {
+            int index = (hand + i) % totalFrames;
+            Frame *frame = frameAt(metadata, index);
+            if (isEvictable(frame) && ATOMIC_LOAD(&frame->isDirty))
+                candidates[found++] = index;
+        }
+        return found;
+    }
+
+    // LRU and LFU: keep the max frames with the lowest eviction key
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        if (!isEvictable(frame) || !ATOMIC_LOAD(&frame->isDirty))
+            continue;
+
+        long key = RELAXED_LOAD(&frame->lastAccessed);
+        if (metadata->strategy == RS_LFU)
+            key += (long)RELAXED_LOAD(&frame->accessCount) << 32;
+        if (found == max && key >= keys[found - 1])
+            continue;
+
+        // Insert into the sorted candidate list
+        j = (found < max) ? found++ : found - 1;
+        while (j > 0 && keys[j - 1] > key)
+        {
+            keys[j] = keys[j - 1];
+            candidates[j] = candidates[j - 1];
+            j--;
+        }
+        keys[j] = key;
+        candidates[j] = i;
+    }
+    return found;
+}
+
+/**
+ * Body of the background writer thread.
+ *
+ * Every interval it writes at most writerMaxPages dirty, unpinned pages
+ * from the eviction end of the pool, so that misses in pinPage find a
+ * clean victim and do not have to write one first.
+ */
+static void *backgroundWriter(void *arg)
+{
+    BufferPoolMetadata *metadata = (BufferPoolMetadata *)arg;
+    int *candidates = (int *)malloc(sizeof(int) * metadata->writerMaxPages);
+    long *keys = (long *)malloc(sizeof(long) * metadata->writerMaxPages);
+    int i, found;
+    RC rc;
+
+    pthread_mutex_lock(&metadata->writerLatch);
+    while (!metadata->writerStop)
+    {
+        // Sleep for one interval unless asked to stop
+        struct timespec wakeup;
+        clock_gettime(CLOCK_REALTIME, &wakeup);
+        wakeup.tv_sec += metadata->writerInterval / 1000;
+        wakeup.tv_nsec += (long)(metadata->writerInterval % 1000) * 1000000;
+        if (wakeup.tv_nsec >= 1000000000)
+        {
+            wakeup.tv_sec++;
+            wakeup.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&metadata->writerWake, &metadata->writerLatch, &wakeup);
+        if (metadata->writerStop)
+            break;
+        pthread_mutex_unlock(&metadata->writerLatch);
+
+        // Clean the pages that are about to be evicted
+        found = findCleaningCandidates(metadata, candidates, keys, metadata->writerMaxPages);
+        for (i = 0; i < found; i++)
+        {
+            int fileId = ATOMIC_LOAD(&frameAt(metadata, candidates[i])->fileId);
+            if (flushFrame(metadata, candidates[i], NO_FILE, &rc))
+            {
+                COUNT_EVENT(metadata, fileId, bgWriteCount);
+            }
+        }
+
+        pthread_mutex_lock(&metadata->writerLatch);
+    }
+    pthread_mutex_unlock(&metadata->writerLatch);
+
+    free(candidates);
+    free(keys);
+    return NULL;
+}
+
+/**
+ * Starts a background writer for the buffer pool.
+ *
+ * @param bm Buffer pool handle
+ * @param intervalMillis Milliseconds to sleep between two rounds
+ * @param maxPagesPerRound Upper bound of pages written per round
+ * @return RC_OK on success, RC_INVALID_PARAMETER for bad rates, RC_ERROR
+ *         if a writer is already running or cannot be started
+ *
+ * The writer trickle-flushes dirty, unpinned pages near the eviction point
+ * (the oldest pages for LRU and LFU, the pages ahead of the hand for FIFO
+ * and CLOCK). The rate limit keeps it from competing with foreground I/O.
+ * A shared pool has one writer serving all files, whichever handle
+ * started it.
+ */
+RC startBackgroundWriter(BM_BufferPool *const bm, int intervalMillis, int maxPagesPerRound)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc = RC_OK;
+
+    if (intervalMillis <= 0 || maxPagesPerRound <= 0)
+        return RC_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&metadata->writerLatch);
+    if (metadata->writerRunning)
+    {
+        rc = RC_ERROR;
+    }
+    else
+    {
+        metadata->writerInterval = intervalMillis;
+        metadata->writerMaxPages = maxPagesPerRound;
+        metadata->writerStop = false;
+        if (pthread_create(&metadata->writerThread, NULL, backgroundWriter, metadata) == 0)
+            metadata->writerRunning = true;
+        else
+            rc = RC_ERROR;
+    }
+    pthread_mutex_unlock(&metadata->writerLatch);
+
+    return rc;
+}
+
+/**
+ * Stops the background writer of the buffer pool.
+ *
+ * @param bm Buffer pool handle
+ * @return RC_OK, also if no writer was running
+ *
+ * Wakes the writer, waits until its current round is finished and joins it.
+ */
+RC stopBackgroundWriter(BM_BufferPool *const bm)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+
+    pthread_mutex_lock(&metadata->writerLatch);
+    if (!metadata->writerRunning)
+    {
+        pthread_mutex_unlock(&metadata->writerLatch);
+        return RC_OK;
+    }
+    metadata->writerStop = true;
+    pthread_cond_signal(&metadata->writerWake);
+    pthread_mutex_unlock(&metadata->writerLatch);
+
+    pthread_join(metadata->writerThread, NULL);
+    metadata->writerRunning = false;
+    return RC_OK;
+}
+
+/**
+ * Body of the evictor: refills the free-frame list from the low up to the
+ * high watermark whenever a miss leaves it below the low watermark
+ */
+static void *evictor(void *arg)
+{
+    BufferPoolMetadata *metadata = (BufferPoolMetadata *)arg;
+    int *batch = (int *)malloc(sizeof(int) * metadata->highWatermark);
+    int numEvicted, i;
+
+    pthread_mutex_lock(&metadata->freeLatch);
+    while (batch != NULL && !metadata->evictorStop)
+    {
+        if (metadata->numFree >= metadata->lowWatermark)
+        {
+            pthread_cond_wait(&metadata->evictorWake, &metadata->freeLatch);
+            continue;
+        }
+        int wanted = metadata->highWatermark - metadata->numFree;
+        pthread_mutex_unlock(&metadata->freeLatch);
+
+        // Evict a batch like a miss would, but with no client waiting
+        evictFrames(metadata, wanted, batch, &numEvicted, true);
+
+        pthread_mutex_lock(&metadata->freeLatch);
+        for (i = 0; i < numEvicted; i++)
+        {
+            ATOMIC_STORE(&frameAt(metadata, batch[i])->fileId, NO_FILE);
+            metadata->freeFrames[metadata->numFree] = batch[i];
+            ATOMIC_STORE(&metadata->numFree, metadata->numFree + 1);
+        }
+
+        // Every frame is pinned: wait for the next miss before retrying
+        if (numEvicted == 0 && !metadata->evictorStop)
+            pthread_cond_wait(&metadata->evictorWake, &metadata->freeLatch);
+    }
+    pthread_mutex_unlock(&metadata->freeLatch);
+
+    free(batch);
+    return NULL;
+}
+
+/**
+ * Starts an evictor keeping a list of free frames for the buffer pool.
+ *
+ * @param bm Buffer pool handle
+ * @param lowWatermark The list is refilled once it holds fewer frames
+ * @param highWatermark Number of free frames a refill evicts up to
+ * @return RC_OK on success, RC_INVALID_PARAMETER for bad watermarks,
+ *         RC_ERROR if an evictor is already running or cannot be started,
+ *         RC_MEMORY_ALLOCATION_ERROR if out of memory
+ *
+ * Without an evictor every miss on a full pool runs the replacement scan
+ * and, for a dirty victim, the write-back itself. With one, a miss pops an
+ * empty frame off the free-frame list, and whenever the list drops below
+ * the low watermark the evictor thread evicts a batch of victims chosen by
+ * the pool's strategy, up to the high watermark, in one pass over the
+ * replacement latch. Its write-backs count as background writes. A miss
+ * that finds the list empty still evicts inline. The free frames are taken
+ * from the pool, so the high watermark must stay below its size. A shared
+ * pool has one evictor serving all files.
+ */
+RC startEvictor(BM_BufferPool *const bm, int lowWatermark, int highWatermark)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc = RC_OK;
+
+    if (lowWatermark <= 0 || highWatermark < lowWatermark || highWatermark >= bm->numPages)
+        return RC_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&metadata->freeLatch);
+    if (metadata->evictorRunning)
+    {
+        pthread_mutex_unlock(&metadata->freeLatch);
+        return RC_ERROR;
+    }
+
+    free(metadata->freeFrames);
+    metadata->freeFrames = (int *)malloc(sizeof(int) * highWatermark);
+    if (metadata->freeFrames == NULL)
+    {
+        rc = RC_MEMORY_ALLOCATION_ERROR;
+    }
+    else
+    {
+        metadata->lowWatermark = lowWatermark;
+        metadata->highWatermark = highWatermark;
+        metadata->evictorStop = false;
+        if (pthread_create(&metadata->evictorThread, NULL, evictor, metadata) == 0)
+            ATOMIC_STORE(&metadata->evictorRunning, true);
+        else
+            rc = RC_ERROR;
+    }
+    pthread_mutex_unlock(&metadata->freeLatch);
+
+    return rc;
+}
+
+/**
+ * Stops the evictor of the buffer pool.
+ *
+ * @param bm Buffer pool handle
+ * @return RC_OK, also if no evictor was running
+ *
+ * Waits until the current batch is evicted, joins the evictor and returns
+ * the frames left on the free-frame list to the pool.
+ */
+RC stopEvictor(BM_BufferPool *const bm)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int i;
+
+    pthread_mutex_lock(&metadata->freeLatch);
+    if (!metadata->evictorRunning)
+    {
+        pthread_mutex_unlock(&metadata->freeLatch);
+        return RC_OK;
+    }
+    metadata->evictorStop = true;
+    pthread_cond_signal(&metadata->evictorWake);
+    pthread_mutex_unlock(&metadata->freeLatch);
+
+    pthread_join(metadata->evictorThread, NULL);
+
+    pthread_mutex_lock(&metadata->freeLatch);
+    ATOMIC_STORE(&metadata->evictorRunning, false);
+    for (i = 0; i < metadata->numFree; i++)
+        releaseFrame(frameAt(metadata, metadata->freeFrames[i]));
+    ATOMIC_STORE(&metadata->numFree, 0);
+    pthread_mutex_unlock(&metadata->freeLatch);
+    return RC_OK;
+}
+
+/**
+ * Orders dirty pages by the time they were first dirtied
+ */
+static int compareDirtiedAt(const void *a, const void *b)
+{
+    long x = ((const DirtyPage *)a)->dirtiedAt, y = ((const DirtyPage *)b)->dirtiedAt;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Writes one page of a checkpoint's dirty-page table back, unless it was
+ * evicted or written since the checkpoint started. The page is pinned and
+ * share-latched for the write: clients keep reading it meanwhile, and
+ * writers that take the exclusive latch wait until it is on disk.
+ */
+static RC checkpointPage(BufferPoolMetadata *metadata, DirtyPage *page, long startedAt)
+{
+    PageTablePartition *part = partitionFor(metadata, page->fileId, page->pageNum);
+    Frame *frame = NULL;
+    RC rc;
+
+    pthread_mutex_lock(&part->latch);
+    while (true)
+    {
+        int index = findFrame(metadata, part, page->fileId, page->pageNum);
+        frame = (index != NO_FRAME) ? frameAt(metadata, index) : NULL;
+        if (frame == NULL || !frame->ioInProgress)
+            break;
+        pthread_cond_wait(&part->ioDone, &part->latch);
+    }
+
+    // A page dirtied after the start was written since, with the changes
+    // the checkpoint has to cover
+    if (frame == NULL || !ATOMIC_LOAD(&frame->isDirty) || RELAXED_LOAD(&frame->dirtiedAt) > startedAt)
+    {
+        pthread_mutex_unlock(&part->latch);
+        return RC_OK;
+    }
+    ATOMIC_INC(&frame->pinCount);
+    pthread_mutex_unlock(&part->latch);
+
+    // The shared latch keeps writers under the exclusive latch out, so the
+    // page goes to disk in a consistent state
+    latchFrame(metadata, page->fileId, page->pageNum, frame, false);
+    ATOMIC_STORE(&frame->isDirty, false);
+    rc = writePageData(metadata, page->fileId, page->pageNum, frame->data);
+    if (rc != RC_OK)
+        ATOMIC_STORE(&frame->isDirty, true);
+    else
+        COUNT_EVENT(metadata, page->fileId, checkpointWrites);
+    unlatchFrame(metadata, page->fileId, page->pageNum, frame);
+    ATOMIC_DEC(&frame->pinCount);
+
+    return rc;
+}
 
-        // Advance clock hand
-        metadata->clockHand = (metadata->clockHand + 1) % metadata->totalFrames;
+/**
+ * Waits until the next page of a paced checkpoint is due; returns false
+ * if the checkpoint is asked to stop meanwhile
+ */
+static bool checkpointPace(BufferPoolMetadata *metadata, int done)
+{
+    long due = metadata->checkpointStart + (long)done * 1000000000L / metadata->checkpointRate;
+    bool stop;
 
-        // Move to next frame
-        current = current->next;
-        if (current == NULL)
+    pthread_mutex_lock(&metadata->checkpointLatch);
+    while (!metadata->checkpointStop && nowNanos() < due)
+    {
+        // Condition variables wait on the real-time clock
+        struct timespec wakeup;
+        long wait = due - nowNanos();
+        clock_gettime(CLOCK_REALTIME, &wakeup);
+        wakeup.tv_sec += wait / 1000000000L;
+        wakeup.tv_nsec += wait % 1000000000L;
+        if (wakeup.tv_nsec >= 1000000000)
         {
-            current = metadata->head;
+            wakeup.tv_sec++;
+            wakeup.tv_nsec -= 1000000000;
         }
+        pthread_cond_timedwait(&metadata->checkpointWake, &metadata->checkpointLatch, &wakeup);
     }
+    stop = metadata->checkpointStop;
+    pthread_mutex_unlock(&metadata->checkpointLatch);
+
+    return !stop;
 }
 
 /**
- * Creates a new buffer pool and initializes required data structures.
- *
- * @param bm Buffer pool handle to initialize
- * @param pageFileName Name of the page file to use
- * @param numPages Number of pages the buffer pool can hold
- * @param strategy Page replacement strategy to use
- * @param stratData Additional data for replacement strategy (if needed)
- * @return RC_OK on successful initialization
- *
- * Allocates and initializes the buffer pool metadata including the frame list,
- * counters, and strategy-specific data. Sets up tracking for page replacements
- * and statistics. The buffer pool starts empty with no frames used.
+ * Body of the checkpoint thread: writes the dirty-page table back, oldest
+ * page first
  */
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
-                  const int numPages, ReplacementStrategy strategy, void *stratData)
+static void *checkpointer(void *arg)
 {
-    // Allocate and initialize metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)malloc(sizeof(BufferPoolMetadata));
-    metadata->head = NULL;
-    metadata->tail = NULL;
-    metadata->fifoHead = NULL;
-    metadata->numFramesUsed = 0;
-    metadata->totalFrames = numPages;
-    metadata->readCount = 0;
-    metadata->writeCount = 0;
-    metadata->clockHand = 0;
-    metadata->globalTimer = 0;
+    BufferPoolMetadata *metadata = (BufferPoolMetadata *)arg;
+    int i;
 
-    // Initialize buffer pool handle
-    bm->pageFile = (char *)pageFileName;
-    bm->numPages = numPages;
-    bm->strategy = strategy;
-    bm->mgmtData = metadata;
+    for (i = 0; i < metadata->checkpointTotal; i++)
+    {
+        if (metadata->checkpointRate > 0 ? !checkpointPace(metadata, i)
+                                         : RELAXED_LOAD(&metadata->checkpointStop))
+            return NULL;
+
+        RC rc = checkpointPage(metadata, &metadata->checkpointPages[i], metadata->checkpointStart);
+        if (rc != RC_OK && metadata->checkpointResult == RC_OK)
+            metadata->checkpointResult = rc;
+        ATOMIC_STORE(&metadata->checkpointDone, i + 1);
+    }
 
-    return RC_OK;
+    ATOMIC_STORE(&metadata->lastCheckpointMicros, (nowNanos() - metadata->checkpointStart) / 1000);
+    ATOMIC_INC(&metadata->numCheckpoints);
+    return NULL;
 }
 
 /**
- * Shuts down an existing buffer pool and releases all resources.
- *
- * @param bm Buffer pool handle to shut down
- * @return RC_OK on success, RC_PINNED_PAGES_IN_BUFFER if pages still pinned
- *
- * Forces all dirty pages to disk, verifies no pages are pinned, and frees
- * all allocated memory. Checks for pinned pages before shutdown to prevent
- * data loss. Releases both page frames and metadata structures.
+ * Joins a finished or stopped checkpoint thread and returns its result;
+ * caller holds checkpointLatch
  */
-RC shutdownBufferPool(BM_BufferPool *const bm)
+static RC joinCheckpoint(BufferPoolMetadata *metadata)
 {
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
-
-    // Write all dirty pages to disk
-    forceFlushPool(bm);
-
-    // Free all allocated memory
-    DLNode *current = metadata->head;
-    while (current != NULL)
-    {
-        // Check for pinned pages
-        if (current->pinCount > 0)
-            return RC_PINNED_PAGES_IN_BUFFER;
+    if (!metadata->checkpointRunning)
+        return RC_OK;
 
-        // Free node and its data
-        DLNode *temp = current;
-        current = current->next;
-        free(temp->data);
-        free(temp);
-    }
+    pthread_mutex_unlock(&metadata->checkpointLatch);
+    pthread_join(metadata->checkpointThread, NULL);
+    pthread_mutex_lock(&metadata->checkpointLatch);
 
-    // Free metadata structure
-    free(metadata);
-    bm->mgmtData = NULL;
-    return RC_OK;
+    metadata->checkpointRunning = false;
+    free(metadata->checkpointPages);
+    metadata->checkpointPages = NULL;
+    metadata->checkpointTotal = 0;
+    ATOMIC_STORE(&metadata->checkpointDone, 0);
+    return metadata->checkpointResult;
 }
 
 /**
- * Writes all dirty pages from buffer pool to disk.
- *
- * @param bm Buffer pool handle containing pages to flush
- * @return RC_OK on successful flush
- *
- * Iterates through all pages in the buffer pool and writes dirty, unpinned
- * pages to disk. Updates write statistics and marks flushed pages as clean.
- * Skips pinned pages even if dirty to maintain consistency.
+ * Stops a running checkpoint, leaving the pages not yet written dirty
  */
-RC forceFlushPool(BM_BufferPool *const bm)
+static void stopCheckpoint(BufferPoolMetadata *metadata)
 {
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
-    DLNode *current = metadata->head;
-
-    // Iterate through all pages
-    while (current != NULL)
+    pthread_mutex_lock(&metadata->checkpointLatch);
+    if (metadata->checkpointRunning)
     {
-        // Write dirty and unpinned pages to disk
-        if (current->isDirty && current->pinCount == 0)
-        {
-            SM_FileHandle fh;
-            openPageFile(bm->pageFile, &fh);
-            writeBlock(current->pageNum, &fh, current->data);
-            current->isDirty = false;
-            metadata->writeCount++;
-            closePageFile(&fh);
-        }
-        current = current->next;
+        ATOMIC_STORE(&metadata->checkpointStop, true);
+        pthread_cond_signal(&metadata->checkpointWake);
+        joinCheckpoint(metadata);
     }
-    return RC_OK;
+    pthread_mutex_unlock(&metadata->checkpointLatch);
 }
 
 /**
- * Marks a page in the buffer pool as dirty.
+ * Starts a fuzzy checkpoint of the buffer pool.
  *
  * @param bm Buffer pool handle
- * @param page Page handle of page to mark
- * @return RC_OK if page found and marked, RC_ERROR if page not in pool
+ * @param pagesPerSecond Pages written per second at most, 0 for no limit
+ * @return RC_OK on success, RC_INVALID_PARAMETER for a negative rate,
+ *         RC_ERROR if a checkpoint is running or cannot be started,
+ *         RC_MEMORY_ALLOCATION_ERROR if out of memory
  *
- * Sets the dirty flag for the specified page indicating it needs to be
- * written to disk before replacement. Essential for maintaining data
- * consistency between memory and disk.
+ * Records the dirty-page table, every dirty page with the time it was
+ * first dirtied, and returns; a background thread then writes the pages
+ * back, oldest first, while clients keep pinning and modifying pages.
+ * Each page is pinned only for its own write. A page that was written and
+ * dirtied again since the start is skipped, so is a page that was
+ * evicted: its changes from before the start are on disk either way. Once
+ * the checkpoint completes, every change made before it started is on
+ * disk, which bounds the work of recovering from a crash; the
+ * oldestDirtyMicros statistic shows the current bound. Unlike
+ * forceFlushPool nothing waits for the writes, and a rate limit keeps
+ * the checkpoint from competing with foreground I/O. A handle bound to a
+ * file checkpoints that file's pages, a bare shared pool all of them.
+ * Progress and duration are reported by getPoolStats.
  */
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC startCheckpoint(BM_BufferPool *const bm, int pagesPerSecond)
 {
-    // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    RC rc = RC_OK;
+    int i;
 
-    // Find the page in buffer pool
-    DLNode *node = findPage(metadata, page->pageNum);
+    if (pagesPerSecond < 0)
+        return RC_INVALID_PARAMETER;
 
-    // If page found, mark it as dirty
-    if (node != NULL)
+    pthread_mutex_lock(&metadata->checkpointLatch);
+    if (metadata->checkpointRunning && ATOMIC_LOAD(&metadata->checkpointDone) < metadata->checkpointTotal)
     {
-        node->isDirty = true;
-        return RC_OK;
+        pthread_mutex_unlock(&metadata->checkpointLatch);
+        return RC_ERROR;
+    }
+    joinCheckpoint(metadata);
+
+    // Record the dirty-page table; the flags are racy, which only moves a
+    // page changed at this very moment into the next checkpoint
+    int totalFrames = ATOMIC_LOAD(&metadata->totalFrames);
+    metadata->checkpointPages = (DirtyPage *)malloc(sizeof(DirtyPage) * (totalFrames + 1));
+    if (metadata->checkpointPages == NULL)
+    {
+        pthread_mutex_unlock(&metadata->checkpointLatch);
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+    metadata->checkpointStart = nowNanos();
+    for (i = 0; i < totalFrames; i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        DirtyPage *page = &metadata->checkpointPages[metadata->checkpointTotal];
+        page->pageNum = ATOMIC_LOAD(&frame->pageNum);
+        page->fileId = ATOMIC_LOAD(&frame->fileId);
+        page->dirtiedAt = RELAXED_LOAD(&frame->dirtiedAt);
+        if (page->pageNum != NO_PAGE && ATOMIC_LOAD(&frame->isDirty) &&
+            (fileId == NO_FILE || page->fileId == fileId))
+            metadata->checkpointTotal++;
+    }
+    qsort(metadata->checkpointPages, metadata->checkpointTotal, sizeof(DirtyPage), compareDirtiedAt);
+
+    metadata->checkpointRate = pagesPerSecond;
+    metadata->checkpointResult = RC_OK;
+    ATOMIC_STORE(&metadata->checkpointStop, false);
+    ATOMIC_STORE(&metadata->checkpointDone, 0);
+    if (pthread_create(&metadata->checkpointThread, NULL, checkpointer, metadata) == 0)
+    {
+        metadata->checkpointRunning = true;
+    }
+    else
+    {
+        free(metadata->checkpointPages);
+        metadata->checkpointPages = NULL;
+        metadata->checkpointTotal = 0;
+        rc = RC_ERROR;
     }
-    return RC_ERROR;
+    pthread_mutex_unlock(&metadata->checkpointLatch);
+
+    return rc;
 }
 
 /**
- * Decrements the pin count of a page.
+ * Waits until the running checkpoint of the buffer pool is complete.
  *
  * @param bm Buffer pool handle
- * @param page Page handle of page to unpin
- * @return RC_OK on success, RC_ERROR if page not found or already unpinned
- *
- * Reduces pin count indicating one fewer client is using the page.
- * Pages with zero pin count become candidates for replacement.
- * Prevents unpinning already unpinned pages.
+ * @return RC_OK if every page was written or no checkpoint was started,
+ *         otherwise the first write error of the checkpoint
  */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC waitCheckpoint(BM_BufferPool *const bm)
 {
-    // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
 
-    // Find the page in buffer pool
-    DLNode *node = findPage(metadata, page->pageNum);
+    pthread_mutex_lock(&metadata->checkpointLatch);
+    RC rc = joinCheckpoint(metadata);
+    pthread_mutex_unlock(&metadata->checkpointLatch);
 
-    // Decrement pin count if page is pinned
-    if (node != NULL && node->pinCount > 0)
-    {
-        node->pinCount--;
-        return RC_OK;
-    }
-    return RC_ERROR;
+    return rc;
 }
 
 /**
- * Immediately writes a page to disk.
+ * Starts recording the page accesses of the buffer pool to a trace file.
  *
  * @param bm Buffer pool handle
- * @param page Page handle of page to force
- * @return RC_OK on successful write, RC_ERROR if page not found
+ * @param traceFileName Name of the trace file, created or truncated
+ * @return RC_OK on success, RC_ERROR if a trace is already running,
+ *         RC_WRITE_FAILED if the file cannot be created,
+ *         RC_MEMORY_ALLOCATION_ERROR if out of memory
  *
- * Opens the page file, writes the page content regardless of dirty flag,
- * and updates write statistics. Useful for immediate persistence of
- * critical data changes.
+ * Every successful pinPage, unpinPage and markDirty on any handle of the
+ * pool appends a BM_TraceRecord with the page, the operation and the time
+ * since the trace was started. Records are buffered and written in
+ * batches; while no trace runs the hooks cost one atomic load. The file
+ * starts with BM_TRACE_MAGIC and is read by bm_sim.
  */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+RC startPageTrace(BM_BufferPool *const bm, const char *traceFileName)
 {
-    // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
-
-    // Find the page in buffer pool
-    DLNode *node = findPage(metadata, page->pageNum);
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc = RC_OK;
 
-    if (node != NULL)
+    pthread_mutex_lock(&metadata->traceLatch);
+    if (metadata->tracing)
     {
-        // Open file and write page
-        SM_FileHandle fh;
-        openPageFile(bm->pageFile, &fh);
-        writeBlock(node->pageNum, &fh, node->data);
-        closePageFile(&fh);
+        pthread_mutex_unlock(&metadata->traceLatch);
+        return RC_ERROR;
+    }
 
-        // Update page and statistics
-        node->isDirty = false;
-        metadata->writeCount++;
-        return RC_OK;
+    metadata->traceBuffer = (BM_TraceRecord *)malloc(sizeof(BM_TraceRecord) * BM_TRACE_BUFFER_RECORDS);
+    metadata->traceFile = fopen(traceFileName, "wb");
+    if (metadata->traceBuffer == NULL || metadata->traceFile == NULL ||
+        fwrite(BM_TRACE_MAGIC, 1, BM_TRACE_MAGIC_LEN, metadata->traceFile) != BM_TRACE_MAGIC_LEN)
+    {
+        rc = (metadata->traceBuffer == NULL) ? RC_MEMORY_ALLOCATION_ERROR : RC_WRITE_FAILED;
+        if (metadata->traceFile != NULL)
+            fclose(metadata->traceFile);
+        free(metadata->traceBuffer);
+        metadata->traceFile = NULL;
+        metadata->traceBuffer = NULL;
     }
-    return RC_ERROR;
+    else
+    {
+        metadata->traceCount = 0;
+        metadata->traceFailed = false;
+        clock_gettime(CLOCK_MONOTONIC, &metadata->traceStart);
+        ATOMIC_STORE(&metadata->tracing, true);
+    }
+    pthread_mutex_unlock(&metadata->traceLatch);
+
+    return rc;
 }
 
 /**
- * Pins a page into the buffer pool, loading it from disk if necessary.
+ * Stops recording page accesses and closes the trace file.
  *
  * @param bm Buffer pool handle
- * @param page Page handle to store the requested page
- * @param pageNum Page number to be pinned
- * @return RC_OK on success, RC_ERROR on failure
+ * @return RC_OK, also if no trace was running, RC_WRITE_FAILED if any part
+ *         of the trace could not be written
  *
- * This function first checks if the page is already in the buffer pool.
- * If present, it increments the pin count and updates metadata.
- * If not, it loads the page from disk into an available frame or
- * replaces a page based on the chosen replacement strategy.
+ * Writes the records still buffered. shutdownBufferPool stops a running
+ * trace as well.
  */
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
-           const PageNumber pageNum)
+RC stopPageTrace(BM_BufferPool *const bm)
 {
-    // Retrieve buffer pool metadata
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
+    RC rc = RC_OK;
 
-    // Check if the page is already in the buffer pool
-    DLNode *node = findPage(metadata, pageNum);
-    if (node != NULL)
+    pthread_mutex_lock(&metadata->traceLatch);
+    if (metadata->tracing)
     {
-        // Page found: Increment pin count and access count
-        node->pinCount++;
-        node->accessCount++; // This may be redundant depending on LRU logic
+        ATOMIC_STORE(&metadata->tracing, false);
+        flushTrace(metadata);
+        if (fclose(metadata->traceFile) != 0 || metadata->traceFailed)
+            rc = RC_WRITE_FAILED;
+        free(metadata->traceBuffer);
+        metadata->traceFile = NULL;
+        metadata->traceBuffer = NULL;
+    }
+    pthread_mutex_unlock(&metadata->traceLatch);
 
-        // Update global timestamp for LRU replacement policy
-        metadata->globalTimer++;
-        node->lastAccessed = metadata->globalTimer;
+    return rc;
+}
 
-        // Update page handle
-        page->pageNum = pageNum;
-        page->data = node->data;
-        return RC_OK;
-    }
+// A resident page and the time of its last access, for dumpBufferPool
+typedef struct WarmPage
+{
+    PageNumber pageNum;
+    int lastAccessed;
+} WarmPage;
 
-    // Check if there is space in the buffer pool
-    if (metadata->numFramesUsed < metadata->totalFrames)
-    {
-        SM_FileHandle fh;
-        RC rc = openPageFile(bm->pageFile, &fh);
-        if (rc != RC_OK)
-            return rc;
+/**
+ * Orders warm pages from the most to the least recently used
+ */
+static int compareRecency(const void *a, const void *b)
+{
+    const WarmPage *x = (const WarmPage *)a, *y = (const WarmPage *)b;
+    return (y->lastAccessed > x->lastAccessed) - (y->lastAccessed < x->lastAccessed);
+}
 
-        // Allocate memory for the new page
-        SM_PageHandle newData = (SM_PageHandle)malloc(PAGE_SIZE);
-        if (newData == NULL)
-        {
-            closePageFile(&fh);
-            return RC_ERROR;
-        }
+/**
+ * Orders page numbers ascending
+ */
+static int comparePages(const void *a, const void *b)
+{
+    PageNumber x = *(const PageNumber *)a, y = *(const PageNumber *)b;
+    return (x > y) - (x < y);
+}
 
-        // Initialize the page memory with zeros
-        memset(newData, 0, PAGE_SIZE);
+/**
+ * Returns a copy of the warm-up file name of a handle: the given name, or
+ * the page file name plus BM_WARM_SUFFIX; NULL without page file
+ */
+static char *warmFileName(BM_BufferPool *const bm, const char *warmFile)
+{
+    if (warmFile != NULL)
+        return strdup(warmFile);
+    if (bm->pageFile == NULL)
+        return NULL;
+
+    char *name = (char *)malloc(strlen(bm->pageFile) + strlen(BM_WARM_SUFFIX) + 1);
+    if (name != NULL)
+        sprintf(name, "%s%s", bm->pageFile, BM_WARM_SUFFIX);
+    return name;
+}
 
-        // Ensure the file has enough pages
-        rc = ensureCapacity(pageNum + 1, &fh);
-        if (rc != RC_OK)
-        {
-            free(newData);
-            closePageFile(&fh);
-            return rc;
-        }
+/**
+ * Reads a run of consecutive pages with one request; pages past the end of
+ * the file are left out. Returns the number of pages read in *numRead.
+ */
+static RC readPageRun(BufferPoolMetadata *metadata, int fileId, PageNumber start, int count,
+                      SM_PageHandle data, int *numRead)
+{
+    PoolFile *file = fileFor(metadata, fileId);
+    RC rc = RC_FILE_HANDLE_NOT_INIT;
+
+    *numRead = 0;
+    pthread_mutex_lock(&file->latch);
+    if (file->fileId == fileId)
+    {
+        if (start + count > file->fileHandle.totalNumPages)
+            count = file->fileHandle.totalNumPages - start;
 
-        // Read the page from disk if it exists
-        if (pageNum < fh.totalNumPages)
+        rc = RC_OK;
+        if (count > 0)
         {
-            rc = readBlock(pageNum, &fh, newData);
-            if (rc != RC_OK)
+            struct timespec begin = startTimer();
+            rc = readBlocks(start, count, &file->fileHandle, data);
+            if (rc == RC_OK)
             {
-                // If read fails, initialize with default content
-                sprintf(newData, "Page-%i", pageNum);
+                recordLatency(metadata, fileId, true, begin);
+                *numRead = count;
             }
         }
-        else
-        {
-            // If the page does not exist, initialize it with default content
-            sprintf(newData, "Page-%i", pageNum);
-        }
-
-        closePageFile(&fh);
-
-        // Create a new node for this page
-        DLNode *newNode = createNode(newData, pageNum);
-        metadata->globalTimer++;
-        newNode->lastAccessed = metadata->globalTimer;
+    }
+    pthread_mutex_unlock(&file->latch);
 
-        // If FIFO queue is empty, set head
-        if (metadata->fifoHead == NULL)
-        {
-            metadata->fifoHead = newNode;
-        }
+    if (*numRead > 0)
+    {
+        COUNTER_ADD(&file->stats.readCount, *numRead);
+        COUNTER_ADD(&metadata->stats.readCount, *numRead);
+    }
+    return rc;
+}
 
-        // Insert the new node into the linked list
-        if (metadata->head == NULL)
-        {
-            metadata->head = metadata->tail = newNode;
-        }
-        else
-        {
-            metadata->tail->next = newNode;
-            newNode->prev = metadata->tail;
-            metadata->tail = newNode;
-        }
+/**
+ * Places a page read by the warm-up into a frame, unpinned. The frame is
+ * filled before it is published, so nobody sees it half loaded. A page
+ * that became resident meanwhile is kept as it is.
+ */
+static RC installPage(BufferPoolMetadata *metadata, int fileId, PageNumber pageNum, SM_PageHandle data)
+{
+    PageTablePartition *part = partitionFor(metadata, fileId, pageNum);
+    int index;
 
-        // Update metadata
-        metadata->numFramesUsed++;
-        metadata->readCount++;
+    RC rc = acquireFrame(metadata, &index);
+    if (rc != RC_OK)
+        return rc;
+    Frame *frame = frameAt(metadata, index);
+    bumpVersion(frame);
+    memcpy(frame->data, data, PAGE_SIZE);
+    bumpVersion(frame);
 
-        // Assign the page handle
-        page->pageNum = pageNum;
-        page->data = newData;
+    pthread_mutex_lock(&part->latch);
+    if (findFrame(metadata, part, fileId, pageNum) != NO_FRAME)
+    {
+        releaseFrame(frame);
+        pthread_mutex_unlock(&part->latch);
         return RC_OK;
     }
+    ATOMIC_STORE(&frame->fileId, fileId);
+    ATOMIC_STORE(&frame->pageNum, pageNum);
+    ATOMIC_STORE(&frame->isDirty, false);
+    RELAXED_STORE(&frame->accessCount, 1);
+    RELAXED_STORE(&frame->lastAccessed, ATOMIC_INC(&metadata->globalTimer));
+    insertFrame(metadata, part, index);
+    ATOMIC_DEC(&frame->pinCount);
+    pthread_mutex_unlock(&part->latch);
 
-    // Buffer pool is full; apply a replacement strategy
-    DLNode *victim = NULL;
-    switch (bm->strategy)
+    return RC_OK;
+}
+
+/**
+ * Writes the pages of a file held in the buffer pool to a warm-up file.
+ *
+ * @param bm Buffer pool handle bound to a page file
+ * @param warmFile Name of the warm-up file, NULL for the page file name
+ *        plus BM_WARM_SUFFIX
+ * @return RC_OK on success, RC_FILE_HANDLE_NOT_INIT for a handle without
+ *         page file, RC_WRITE_FAILED if the file cannot be written
+ *
+ * The page numbers are stored from the most to the least recently used,
+ * only the numbers and not the contents, so the file stays small. It is
+ * written under a temporary name and renamed, so a crash never leaves a
+ * torn list behind. Can be called at any time, e.g. periodically, while
+ * the pool is in use; pages loaded or evicted meanwhile may or may not be
+ * listed.
+ */
+RC dumpBufferPool(BM_BufferPool *const bm, const char *warmFile)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    int totalFrames = ATOMIC_LOAD(&metadata->totalFrames);
+    int count = 0, i;
+    RC rc = RC_OK;
+
+    if (fileId == NO_FILE || fileFor(metadata, fileId)->inMemory)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    char *name = warmFileName(bm, warmFile);
+    char *tmpName = (name == NULL) ? NULL : (char *)malloc(strlen(name) + 5);
+    WarmPage *pages = (WarmPage *)malloc(sizeof(WarmPage) * totalFrames);
+    if (name == NULL || tmpName == NULL || pages == NULL)
     {
-    case RS_FIFO:
-        victim = replaceFIFO(metadata);
-        break;
-    case RS_LRU:
-        victim = replaceLRU(metadata);
-        break;
-    case RS_CLOCK:
-        victim = replaceCLOCK(metadata);
-        break;
-    case RS_LRU_K:
-        printf("\n LRU-k algorithm not implemented");
-        break;
-    case RS_LFU:
-        victim = replaceLFU(metadata);
-        break;
-    default:
-        printf("\nAlgorithm Not Implemented\n");
-        break;
+        free(name);
+        free(tmpName);
+        free(pages);
+        return RC_MEMORY_ALLOCATION_ERROR;
     }
+    sprintf(tmpName, "%s.tmp", name);
 
-    // Ensure a victim is found and is not pinned
-    if (victim == NULL || victim->pinCount > 0)
-        return RC_ERROR;
-
-    // If the victim page is dirty, write it to disk before replacing
-    if (victim->isDirty)
+    // Collect the file's pages with the time of their last access
+    for (i = 0; i < totalFrames; i++)
     {
-        SM_FileHandle fh;
-        RC rc = openPageFile(bm->pageFile, &fh);
-        if (rc != RC_OK)
-            return rc;
-
-        writeBlock(victim->pageNum, &fh, victim->data);
-        closePageFile(&fh);
-        metadata->writeCount++;
+        Frame *frame = frameAt(metadata, i);
+        PageNumber pageNum = ATOMIC_LOAD(&frame->pageNum);
+        if (pageNum != NO_PAGE && frameVisible(bm, frame))
+        {
+            pages[count].pageNum = pageNum;
+            pages[count].lastAccessed = RELAXED_LOAD(&frame->lastAccessed);
+            count++;
+        }
     }
+    qsort(pages, count, sizeof(WarmPage), compareRecency);
 
-    // Reset the victim's memory for new data
-    memset(victim->data, 0, PAGE_SIZE);
-
-    // Open the page file again for reading
-    SM_FileHandle fh;
-    RC rc = openPageFile(bm->pageFile, &fh);
-    if (rc != RC_OK)
-        return rc;
-
-    // Ensure sufficient capacity before reading
-    rc = ensureCapacity(pageNum + 1, &fh);
-    if (rc != RC_OK)
+    FILE *out = fopen(tmpName, "wb");
+    if (out == NULL)
     {
-        closePageFile(&fh);
-        return rc;
+        rc = RC_WRITE_FAILED;
     }
-
-    // Read or initialize the new page content
-    if (pageNum < fh.totalNumPages)
+    else
     {
-        rc = readBlock(pageNum, &fh, victim->data);
-        if (rc != RC_OK)
+        bool ok = fwrite(BM_WARM_MAGIC, 1, BM_WARM_MAGIC_LEN, out) == BM_WARM_MAGIC_LEN &&
+                  fwrite(&count, sizeof(int), 1, out) == 1;
+        for (i = 0; ok && i < count; i++)
+            ok = fwrite(&pages[i].pageNum, sizeof(PageNumber), 1, out) == 1;
+        if (fclose(out) != 0 || !ok || rename(tmpName, name) != 0)
         {
-            sprintf(victim->data, "Page-%i", pageNum);
+            remove(tmpName);
+            rc = RC_WRITE_FAILED;
         }
     }
-    else
+
+    free(pages);
+    free(tmpName);
+    free(name);
+    return rc;
+}
+
+/**
+ * Loads the pages listed in a warm-up file into the buffer pool.
+ *
+ * @param bm Buffer pool handle bound to a page file
+ * @param warmFile Name of the warm-up file, NULL for the page file name
+ *        plus BM_WARM_SUFFIX
+ * @return RC_OK on success, RC_FILE_NOT_FOUND if there is no warm-up file,
+ *         RC_READ_NON_EXISTING_PAGE if it is damaged,
+ *         RC_FILE_HANDLE_NOT_INIT for a handle without page file
+ *
+ * Takes the most recently used pages of the list, as many as the pool has
+ * frames, sorts them by page number and reads runs of consecutive pages
+ * with one large read each (up to BM_WARM_READ_PAGES pages), so the disk
+ * sees a sorted sequential scan instead of random misses. The pages are
+ * left unpinned and clean, and their recency is restored from the list,
+ * so LRU evicts them in the order they were used before. Pages that no
+ * longer exist in the file are skipped.
+ */
+RC loadBufferPool(BM_BufferPool *const bm, const char *warmFile)
+{
+    BufferPoolMetadata *metadata = poolOf(bm);
+    int fileId = fileOf(bm);
+    char magic[BM_WARM_MAGIC_LEN];
+    int count = 0, i, j;
+    RC rc = RC_OK;
+
+    if (fileId == NO_FILE || fileFor(metadata, fileId)->inMemory)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    char *name = warmFileName(bm, warmFile);
+    if (name == NULL)
+        return RC_MEMORY_ALLOCATION_ERROR;
+    FILE *in = fopen(name, "rb");
+    free(name);
+    if (in == NULL)
+        return RC_FILE_NOT_FOUND;
+
+    // Read the list, keeping only as many pages as fit into the pool
+    if (fread(magic, 1, BM_WARM_MAGIC_LEN, in) != BM_WARM_MAGIC_LEN ||
+        memcmp(magic, BM_WARM_MAGIC, BM_WARM_MAGIC_LEN) != 0 ||
+        fread(&count, sizeof(int), 1, in) != 1 || count < 0)
+    {
+        fclose(in);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (count > bm->numPages)
+        count = bm->numPages;
+
+    PageNumber *recent = (PageNumber *)malloc(sizeof(PageNumber) * (count + 1));
+    PageNumber *sorted = (PageNumber *)malloc(sizeof(PageNumber) * (count + 1));
+    char *buffer = (char *)malloc((size_t)BM_WARM_READ_PAGES * PAGE_SIZE);
+    if (recent == NULL || sorted == NULL || buffer == NULL)
+        rc = RC_MEMORY_ALLOCATION_ERROR;
+    else if (fread(recent, sizeof(PageNumber), count, in) != (size_t)count)
+        rc = RC_READ_NON_EXISTING_PAGE;
+    fclose(in);
+
+    if (rc == RC_OK)
     {
-        sprintf(victim->data, "Page-%i", pageNum);
+        memcpy(sorted, recent, sizeof(PageNumber) * count);
+        qsort(sorted, count, sizeof(PageNumber), comparePages);
     }
 
-    closePageFile(&fh);
+    // Read runs of consecutive pages in ascending order
+    i = 0;
+    while (rc == RC_OK && i < count)
+    {
+        PageNumber start = sorted[i];
+        int length = 1, numRead;
 
-    // Update the victim node with the new page details
-    victim->pageNum = pageNum;
-    victim->isDirty = false;
-    victim->pinCount = 1;
-    metadata->globalTimer++;
-    victim->lastAccessed = metadata->globalTimer;
+        if (start < 0 || (i > 0 && start == sorted[i - 1]))
+        {
+            i++;
+            continue;
+        }
+        while (i + length < count && length < BM_WARM_READ_PAGES && sorted[i + length] == start + length)
+            length++;
+
+        rc = readPageRun(metadata, fileId, start, length, buffer, &numRead);
+        for (j = 0; rc == RC_OK && j < numRead; j++)
+            rc = installPage(metadata, fileId, start + j, buffer + (size_t)j * PAGE_SIZE);
+        if (numRead < length)
+            break; // The rest of the list lies past the end of the file
+        i += length;
+    }
 
-    // Assign the page handle
-    page->pageNum = pageNum;
-    page->data = victim->data;
+    // Replay the recency, least recently used page first
+    for (i = count - 1; rc == RC_OK && i >= 0; i--)
+    {
+        PageTablePartition *part = partitionFor(metadata, fileId, recent[i]);
+        pthread_mutex_lock(&part->latch);
+        int index = findFrame(metadata, part, fileId, recent[i]);
+        if (index != NO_FRAME)
+            RELAXED_STORE(&frameAt(metadata, index)->lastAccessed, ATOMIC_INC(&metadata->globalTimer));
+        pthread_mutex_unlock(&part->latch);
+    }
 
-    // Update read count
-    metadata->readCount++;
-    return RC_OK;
+    free(recent);
+    free(sorted);
+    free(buffer);
+    return rc;
 }
 
 /**
@@ -653,29 +3824,29 @@ RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
  * @return Array of page numbers, NO_PAGE for empty frames
  *
  * Allocates and returns an array showing which page occupies each frame
- * in the buffer pool. The array index corresponds to frame number.
- * Caller must free the returned array.
+ * in the buffer pool. The array index corresponds to frame number, counting
+ * only frames not retired by resizeBufferPool. A handle bound to a file
+ * sees only its own pages in a shared pool. The array has bm->numPages
+ * entries. Caller must free the returned array.
  */
 PageNumber *getFrameContents(BM_BufferPool *const bm)
 {
     // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
 
     // Allocate array for frame contents
-    PageNumber *frameContents = malloc(sizeof(PageNumber) * metadata->totalFrames);
+    PageNumber *frameContents = malloc(sizeof(PageNumber) * bm->numPages);
+    int count = 0;
 
-    // Initialize all frames to NO_PAGE
-    for (int i = 0; i < metadata->totalFrames; i++)
-        frameContents[i] = NO_PAGE;
-
-    // Fill in actual page numbers
-    DLNode *current = metadata->head;
-    int index = 0;
-    while (current != NULL && index < metadata->totalFrames)
+    // Fill in page numbers, NO_PAGE for empty frames and other files' pages
+    for (int i = 0; i < ATOMIC_LOAD(&metadata->totalFrames) && count < bm->numPages; i++)
     {
-        frameContents[index++] = current->pageNum;
-        current = current->next;
+        Frame *frame = frameAt(metadata, i);
+        if (!ATOMIC_LOAD(&frame->retired))
+            frameContents[count++] = frameVisible(bm, frame) ? ATOMIC_LOAD(&frame->pageNum) : NO_PAGE;
     }
+    while (count < bm->numPages)
+        frameContents[count++] = NO_PAGE;
 
     return frameContents;
 }
@@ -693,23 +3864,21 @@ PageNumber *getFrameContents(BM_BufferPool *const bm)
 bool *getDirtyFlags(BM_BufferPool *const bm)
 {
     // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
 
     // Allocate array for dirty flags
-    bool *dirtyFlags = malloc(sizeof(bool) * metadata->totalFrames);
-
-    // Initialize all flags to false
-    for (int i = 0; i < metadata->totalFrames; i++)
-        dirtyFlags[i] = false;
+    bool *dirtyFlags = malloc(sizeof(bool) * bm->numPages);
+    int count = 0;
 
     // Set flags for dirty pages
-    DLNode *current = metadata->head;
-    int index = 0;
-    while (current != NULL && index < metadata->totalFrames)
+    for (int i = 0; i < ATOMIC_LOAD(&metadata->totalFrames) && count < bm->numPages; i++)
     {
-        dirtyFlags[index++] = current->isDirty;
-        current = current->next;
+        Frame *frame = frameAt(metadata, i);
+        if (!ATOMIC_LOAD(&frame->retired))
+            dirtyFlags[count++] = frameVisible(bm, frame) && ATOMIC_LOAD(&frame->isDirty);
     }
+    while (count < bm->numPages)
+        dirtyFlags[count++] = false;
 
     return dirtyFlags;
 }
@@ -722,28 +3891,29 @@ bool *getDirtyFlags(BM_BufferPool *const bm)
  *
  * Returns array showing how many clients are using each page in the
  * buffer pool. Zero indicates page is unused and can be replaced.
- * Caller must free the returned array.
+ * Empty frames report zero, including those the free-frame list holds
+ * pinned for the next miss. Caller must free the returned array.
  */
 int *getFixCounts(BM_BufferPool *const bm)
 {
     // Get metadata structure
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
+    BufferPoolMetadata *metadata = poolOf(bm);
 
     // Allocate array for fix counts
-    int *fixCounts = malloc(sizeof(int) * metadata->totalFrames);
-
-    // Initialize all counts to 0
-    for (int i = 0; i < metadata->totalFrames; i++)
-        fixCounts[i] = 0;
+    int *fixCounts = malloc(sizeof(int) * bm->numPages);
+    int count = 0;
 
     // Fill in actual fix counts
-    DLNode *current = metadata->head;
-    int index = 0;
-    while (current != NULL && index < metadata->totalFrames)
+    for (int i = 0; i < ATOMIC_LOAD(&metadata->totalFrames) && count < bm->numPages; i++)
     {
-        fixCounts[index++] = current->pinCount;
-        current = current->next;
+        Frame *frame = frameAt(metadata, i);
+        if (!ATOMIC_LOAD(&frame->retired))
+            fixCounts[count++] = (ATOMIC_LOAD(&frame->pageNum) != NO_PAGE && frameVisible(bm, frame))
+                                     ? ATOMIC_LOAD(&frame->pinCount)
+                                     : 0;
     }
+    while (count < bm->numPages)
+        fixCounts[count++] = 0;
 
     return fixCounts;
 }
@@ -754,14 +3924,14 @@ int *getFixCounts(BM_BufferPool *const bm)
  * @param bm Buffer pool handle
  * @return Number of read operations performed
  *
- * Provides count of disk reads since pool initialization. Used for
- * monitoring and optimizing buffer pool performance.
+ * Provides count of disk reads since pool initialization, or since the
+ * file was attached for a handle of a shared pool. Used for monitoring
+ * and optimizing buffer pool performance.
  */
 int getNumReadIO(BM_BufferPool *const bm)
 {
-    // Return read counter from metadata
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
-    return metadata->readCount;
+    // Return read counter of the handle's file, or of the whole pool
+    return (int)ATOMIC_LOAD(&countersOf(bm)->readCount);
 }
 
 /**
@@ -775,7 +3945,100 @@ int getNumReadIO(BM_BufferPool *const bm)
  */
 int getNumWriteIO(BM_BufferPool *const bm)
 {
-    // Return write counter from metadata
-    BufferPoolMetadata *metadata = (BufferPoolMetadata *)bm->mgmtData;
-    return metadata->writeCount;
+    // Return write counter of the handle's file, or of the whole pool
+    return (int)ATOMIC_LOAD(&countersOf(bm)->writeCount);
+}
+
+/**
+ * Returns number of pages written by the background writer.
+ *
+ * @param bm Buffer pool handle
+ * @return Number of pages cleaned ahead of eviction
+ *
+ * Together with getNumForegroundWriteIO this shows how well the writer
+ * keeps up: ideally almost every dirty page is written here.
+ */
+int getNumBackgroundWriteIO(BM_BufferPool *const bm)
+{
+    return (int)ATOMIC_LOAD(&countersOf(bm)->bgWriteCount);
+}
+
+/**
+ * Returns number of dirty victims written by pinPage itself.
+ *
+ * @param bm Buffer pool handle
+ * @return Number of writes on the miss path
+ *
+ * Each of these writes delayed a miss until the victim was on disk.
+ * Forced writes and pool flushes are not included.
+ */
+int getNumForegroundWriteIO(BM_BufferPool *const bm)
+{
+    return (int)ATOMIC_LOAD(&countersOf(bm)->fgWriteCount);
+}
+
+/**
+ * Takes a snapshot of the buffer pool statistics.
+ *
+ * @param bm Buffer pool handle
+ * @param stats Filled with the counters since the pool was created
+ * @return RC_OK on success, RC_ERROR if the pool is not open
+ *
+ * A handle bound to a file of a shared pool reports the events of that
+ * file, a bare shared pool those of all files. The counters are read one
+ * by one while the pool keeps running, so they are individually exact but
+ * may be a few events apart from each other. Checkpoint progress and
+ * duration are those of the whole pool; oldestDirtyMicros is found by a
+ * pass over the frames.
+ */
+RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *stats)
+{
+    if (bm->mgmtData == NULL)
+        return RC_ERROR;
+
+    BufferPoolMetadata *metadata = poolOf(bm);
+    PoolCounters *counters = countersOf(bm);
+    long oldest = 0, now = nowNanos();
+    int i;
+
+    stats->numPages = bm->numPages;
+    stats->hits = ATOMIC_LOAD(&counters->hits);
+    stats->misses = ATOMIC_LOAD(&counters->misses);
+    stats->cleanEvictions = ATOMIC_LOAD(&counters->cleanEvictions);
+    stats->dirtyEvictions = ATOMIC_LOAD(&counters->dirtyEvictions);
+    stats->forcedWrites = ATOMIC_LOAD(&counters->forcedWrites);
+    stats->backgroundWrites = ATOMIC_LOAD(&counters->bgWriteCount);
+    stats->pinWaits = ATOMIC_LOAD(&counters->pinWaits);
+    stats->reads = ATOMIC_LOAD(&counters->readCount);
+    stats->writes = ATOMIC_LOAD(&counters->writeCount);
+    for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+    {
+        stats->readLatency[i] = ATOMIC_LOAD(&counters->readLatency[i]);
+        stats->writeLatency[i] = ATOMIC_LOAD(&counters->writeLatency[i]);
+    }
+
+    // Checkpoints run for the whole pool
+    stats->checkpoints = ATOMIC_LOAD(&metadata->numCheckpoints);
+    stats->checkpointWrites = ATOMIC_LOAD(&counters->checkpointWrites);
+    pthread_mutex_lock(&metadata->checkpointLatch);
+    stats->checkpointPending = metadata->checkpointTotal - ATOMIC_LOAD(&metadata->checkpointDone);
+    pthread_mutex_unlock(&metadata->checkpointLatch);
+    stats->lastCheckpointMicros = ATOMIC_LOAD(&metadata->lastCheckpointMicros);
+    // Only the frames in use count, not the rest of a partly used extent
+    stats->hugePageFrames = 0;
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+        if (metadata->arenaPages[i >> BM_EXTENT_SHIFT] != BM_HUGE_PAGES_NONE &&
+            !ATOMIC_LOAD(&frameAt(metadata, i)->retired))
+            stats->hugePageFrames++;
+
+    // The oldest unwritten change is where recovery would have to start
+    for (i = 0; i < ATOMIC_LOAD(&metadata->totalFrames); i++)
+    {
+        Frame *frame = frameAt(metadata, i);
+        if (ATOMIC_LOAD(&frame->isDirty) && ATOMIC_LOAD(&frame->pageNum) != NO_PAGE &&
+            frameVisible(bm, frame) && now - RELAXED_LOAD(&frame->dirtiedAt) > oldest)
+            oldest = now - RELAXED_LOAD(&frame->dirtiedAt);
+    }
+    stats->oldestDirtyMicros = oldest / 1000;
+    return RC_OK;
 }
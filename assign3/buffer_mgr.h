@@ -33,6 +33,75 @@ typedef struct BM_PageHandle {
   char *data;
 } BM_PageHandle;
 
+// Replacement hints: cold pages are evicted first, hot pages last
+typedef enum BM_PageHint {
+  BM_HINT_NONE = 0,
+  BM_HINT_HOT = 1,
+  BM_HINT_COLD = 2
+} BM_PageHint;
+
+// Latency histograms: bucket i counts I/Os taking 2^i to 2^(i+1)
+// microseconds, the last bucket everything longer
+#define BM_LATENCY_BUCKETS 24
+
+typedef struct BM_PoolStats {
+  int numPages;
+  long hits;             // pins of resident pages
+  long misses;           // pins that read the page from disk
+  long cleanEvictions;   // victims reused without a write
+  long dirtyEvictions;   // victims written back before reuse
+  long forcedWrites;     // pages written by forcePage
+  long backgroundWrites; // pages cleaned by the background writer
+  long pinWaits;         // pins that waited for a read or write in flight
+  long reads;
+  long writes;
+  long checkpoints;          // checkpoints completed
+  long checkpointWrites;     // pages written by checkpoints
+  long checkpointPending;    // pages the running checkpoint has yet to visit
+  long lastCheckpointMicros; // duration of the last completed checkpoint
+  long oldestDirtyMicros;    // age of the oldest change not yet on disk
+  long hugePageFrames;       // frames in use mapped with explicit or advised huge pages
+  long readLatency[BM_LATENCY_BUCKETS];
+  long writeLatency[BM_LATENCY_BUCKETS];
+} BM_PoolStats;
+
+// Page access traces: a file holds BM_TRACE_MAGIC followed by one record
+// per pinPage, unpinPage and markDirty, see startPageTrace
+#define BM_TRACE_MAGIC "BMTRACE1"
+#define BM_TRACE_MAGIC_LEN 8
+
+typedef enum BM_TraceOp {
+  BM_TRACE_PIN = 0,
+  BM_TRACE_UNPIN = 1,
+  BM_TRACE_DIRTY = 2
+} BM_TraceOp;
+
+typedef struct BM_TraceRecord {
+  long timestamp;        // nanoseconds since the trace was started
+  PageNumber pageNum;
+  unsigned short file;   // low bits of the file id, tells the files of a shared pool apart
+  unsigned char op;      // a BM_TraceOp
+  unsigned char reserved;
+} BM_TraceRecord;
+
+// Warm-up across restarts: the pages held by a pool are listed in a small
+// file, by default named after the page file plus BM_WARM_SUFFIX
+#define BM_WARM_SUFFIX ".warm"
+
+// Memory backing the frames of a pool
+typedef enum BM_HugePages {
+  BM_HUGE_PAGES_NONE = 0,        // normal pages
+  BM_HUGE_PAGES_TRANSPARENT = 1, // transparent huge pages, madvise(MADV_HUGEPAGE)
+  BM_HUGE_PAGES_EXPLICIT = 2     // MAP_HUGETLB, falling back to transparent huge pages
+} BM_HugePages;
+
+typedef struct BM_PoolOptions {
+  bool dumpOnShutdown;  // list the resident pages in the warm-up file on shutdown
+  bool loadOnStart;     // load the pages listed in the warm-up file on start
+  const char *warmFile; // warm-up file, NULL for the default name
+  BM_HugePages hugePages; // backing of the frames
+} BM_PoolOptions;
+
 // convenience macros
 #define MAKE_POOL()					\
   ((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -44,8 +113,18 @@ typedef struct BM_PageHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		  const int numPages, ReplacementStrategy strategy, 
 		  void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+			     const int numPages, ReplacementStrategy strategy,
+			     void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+
+// Shared Buffer Pool Interface
+RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages,
+			ReplacementStrategy strategy, void *stratData);
+RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const pool,
+		    const char *const pageFileName);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -53,6 +132,15 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 	    const PageNumber pageNum);
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+	     const PageNumber *pageNums, const int n);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+	       const int n);
+RC prefetchPage (BM_BufferPool *const bm, const PageNumber pageNum);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber start,
+		  const int count);
+RC setPageHint (BM_BufferPool *const bm, const PageNumber pageNum,
+		const BM_PageHint hint);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,6 +148,41 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumBackgroundWriteIO (BM_BufferPool *const bm);
+int getNumForegroundWriteIO (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats);
+
+// Background Writer Interface
+RC startBackgroundWriter (BM_BufferPool *const bm, int intervalMillis,
+			  int maxPagesPerRound);
+RC stopBackgroundWriter (BM_BufferPool *const bm);
+
+// Evictor Interface
+RC startEvictor (BM_BufferPool *const bm, int lowWatermark,
+		 int highWatermark);
+RC stopEvictor (BM_BufferPool *const bm);
+
+// Checkpoint Interface
+RC startCheckpoint (BM_BufferPool *const bm, int pagesPerSecond);
+RC waitCheckpoint (BM_BufferPool *const bm);
+
+// Page Content Latch Interface
+RC latchPageShared (BM_BufferPool *const bm, BM_PageHandle *const page);
+RC latchPageExclusive (BM_BufferPool *const bm, BM_PageHandle *const page);
+RC unlatchPage (BM_BufferPool *const bm, BM_PageHandle *const page);
+
+// Optimistic Read Interface
+RC readPageOptimistic (BM_BufferPool *const bm, BM_PageHandle *const page,
+		       const PageNumber pageNum, const int offset,
+		       const int length, char *dest);
+
+// Warm-up Interface
+RC dumpBufferPool (BM_BufferPool *const bm, const char *warmFile);
+RC loadBufferPool (BM_BufferPool *const bm, const char *warmFile);
+
+// Page Access Trace Interface
+RC startPageTrace (BM_BufferPool *const bm, const char *traceFileName);
+RC stopPageTrace (BM_BufferPool *const bm);
 
 #endif
 
@@ -3,9 +3,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static const char *strategyName (ReplacementStrategy strategy);
+static int sprintHistogram (char *message, long *buckets, char *separator);
+static int sprintJsonString (char *message, const char *string);
 
 // external functions
 void 
@@ -79,27 +83,152 @@ sprintPageContent (BM_PageHandle *const page)
 }
 
 void
-printStrat (BM_BufferPool *const bm)
+printPoolStats (BM_BufferPool *const bm, BM_StatsFormat format)
+{
+  char *message = sprintPoolStats(bm, format);
+
+  if (message == NULL)
+    return;
+  printf("%s", message);
+  free(message);
+}
+
+char *
+sprintPoolStats (BM_BufferPool *const bm, BM_StatsFormat format)
 {
-  switch (bm->strategy)
+  BM_PoolStats stats;
+  const char *strategy;
+  char number[16];
+  char *message;
+  double hitRatio;
+  int i;
+  int pos = 0;
+
+  if (getPoolStats(bm, &stats) != RC_OK)
+    return NULL;
+  hitRatio = (stats.hits + stats.misses > 0) ? (double) stats.hits / (stats.hits + stats.misses) : 0;
+  strategy = strategyName(bm->strategy);
+  if (strategy == NULL)
+    {
+      sprintf(number, "%i", bm->strategy);
+      strategy = number;
+    }
+
+  // every number takes at most 21 characters, an escaped character of
+  // the file name at most 6
+  message = (char *) malloc(1024 + (2 * BM_LATENCY_BUCKETS * 40) + ((bm->pageFile != NULL) ? 6 * strlen(bm->pageFile) : 0));
+  if (message == NULL)
+    return NULL;
+
+  if (format == BM_STATS_CSV)
+    {
+      pos += sprintf(message + pos, "page_file,strategy,num_pages,hits,misses,hit_ratio,"
+                     "clean_evictions,dirty_evictions,forced_writes,background_writes,pin_waits,reads,writes,"
+                     "checkpoints,checkpoint_writes,checkpoint_pending,last_checkpoint_us,oldest_dirty_us,huge_page_frames");
+      for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+        pos += sprintf(message + pos, ",read_us_%i", i);
+      for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+        pos += sprintf(message + pos, ",write_us_%i", i);
+      pos += sprintf(message + pos, "\n%s,%s,%i,%li,%li,%.4f,%li,%li,%li,%li,%li,%li,%li,%li,%li,%li,%li,%li,%li,",
+                     (bm->pageFile != NULL) ? bm->pageFile : "", strategy, stats.numPages,
+                     stats.hits, stats.misses, hitRatio, stats.cleanEvictions, stats.dirtyEvictions,
+                     stats.forcedWrites, stats.backgroundWrites, stats.pinWaits, stats.reads, stats.writes,
+                     stats.checkpoints, stats.checkpointWrites, stats.checkpointPending,
+                     stats.lastCheckpointMicros, stats.oldestDirtyMicros, stats.hugePageFrames);
+      pos += sprintHistogram(message + pos, stats.readLatency, ",");
+      pos += sprintf(message + pos, ",");
+      pos += sprintHistogram(message + pos, stats.writeLatency, ",");
+      pos += sprintf(message + pos, "\n");
+      return message;
+    }
+
+  pos += sprintf(message + pos, "{\"pageFile\": ");
+  if (bm->pageFile != NULL)
+    pos += sprintJsonString(message + pos, bm->pageFile);
+  else
+    pos += sprintf(message + pos, "null");
+  pos += sprintf(message + pos, ", ");
+  pos += sprintf(message + pos, "\"strategy\": \"%s\", \"numPages\": %i, \"hits\": %li, \"misses\": %li, "
+                 "\"hitRatio\": %.4f, \"cleanEvictions\": %li, \"dirtyEvictions\": %li, "
+                 "\"forcedWrites\": %li, \"backgroundWrites\": %li, \"pinWaits\": %li, "
+                 "\"reads\": %li, \"writes\": %li, \"checkpoints\": %li, "
+                 "\"checkpointWrites\": %li, \"checkpointPending\": %li, "
+                 "\"lastCheckpointMicros\": %li, \"oldestDirtyMicros\": %li, \"hugePageFrames\": %li, ",
+                 strategy, stats.numPages, stats.hits, stats.misses, hitRatio,
+                 stats.cleanEvictions, stats.dirtyEvictions, stats.forcedWrites,
+                 stats.backgroundWrites, stats.pinWaits, stats.reads, stats.writes,
+                 stats.checkpoints, stats.checkpointWrites, stats.checkpointPending,
+                 stats.lastCheckpointMicros, stats.oldestDirtyMicros, stats.hugePageFrames);
+  pos += sprintf(message + pos, "\"readLatencyMicros\": [");
+  pos += sprintHistogram(message + pos, stats.readLatency, ", ");
+  pos += sprintf(message + pos, "], \"writeLatencyMicros\": [");
+  pos += sprintHistogram(message + pos, stats.writeLatency, ", ");
+  pos += sprintf(message + pos, "]}\n");
+
+  return message;
+}
+
+int
+sprintHistogram (char *message, long *buckets, char *separator)
+{
+  int i;
+  int pos = 0;
+
+  for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+    pos += sprintf(message + pos, "%s%li", (i == 0) ? "" : separator, buckets[i]);
+
+  return pos;
+}
+
+int
+sprintJsonString (char *message, const char *string)
+{
+  const unsigned char *c;
+  int pos = 0;
+
+  message[pos++] = '"';
+  for (c = (const unsigned char *) string; *c != '\0'; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        pos += sprintf(message + pos, "\\%c", *c);
+      else if (*c < 0x20)
+        pos += sprintf(message + pos, "\\u%04x", *c);
+      else
+        message[pos++] = *c;
+    }
+  message[pos++] = '"';
+  message[pos] = '\0';
+
+  return pos;
+}
+
+const char *
+strategyName (ReplacementStrategy strategy)
+{
+  switch (strategy)
     {
     case RS_FIFO:
-      printf("FIFO");
-      break;
+      return "FIFO";
     case RS_LRU:
-      printf("LRU");
-      break;
+      return "LRU";
     case RS_CLOCK:
-      printf("CLOCK");
-      break;
+      return "CLOCK";
     case RS_LFU:
-      printf("LFU");
-      break;
+      return "LFU";
     case RS_LRU_K:
-      printf("LRU-K");
-      break;
+      return "LRU-K";
     default:
-      printf("%i", bm->strategy);
-      break;
+      return NULL;
     }
 }
+
+void
+printStrat (BM_BufferPool *const bm)
+{
+  const char *name = strategyName(bm->strategy);
+
+  if (name != NULL)
+    printf("%s", name);
+  else
+    printf("%i", bm->strategy);
+}
@@ -3,10 +3,21 @@
 
 #include "buffer_mgr.h"
 
+// output formats of the statistics dump
+typedef enum BM_StatsFormat {
+  BM_STATS_JSON = 0,
+  BM_STATS_CSV = 1
+} BM_StatsFormat;
+
 // debug functions
 void printPoolContent (BM_BufferPool *const bm);
 void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
+// statistics dump for monitoring (JSON object or CSV header and row);
+// sprintPoolStats returns NULL if the pool is not open or out of memory
+void printPoolStats (BM_BufferPool *const bm, BM_StatsFormat format);
+char *sprintPoolStats (BM_BufferPool *const bm, BM_StatsFormat format);
+
 #endif
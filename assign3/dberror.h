@@ -19,6 +19,7 @@ typedef int RC;
 #define RC_PINNED_PAGES_IN_BUFFER 500 // Added a new definition for Buffer Manager
 #define RC_INVALID_PARAMETER -400
 #define RC_MEMORY_ALLOCATION_ERROR 501
+#define RC_BUFFER_POOL_IN_USE 502 // Shared buffer pool still has attached handles
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -35,6 +36,8 @@ typedef int RC;
 // Added new definitions for Record Manager
 #define RC_RM_NO_TUPLE_WITH_GIVEN_RID 600
 #define RC_SCAN_CONDITION_NOT_FOUND 601
+#define RC_RM_RECORD_DOES_NOT_FIT 602 // an updated record outgrew its page
+#define RC_RM_ATTR_NOT_NULLABLE 603 // NULL set into an attribute that is not nullable
 
 /* holder for error messages */
 extern char *RC_message;
@@ -7,9 +7,15 @@
 #include "tables.h"
 
 // implementations
+// three-valued logic: comparing NULL yields NULL, standing for unknown
 RC 
 valueEquals (Value *left, Value *right, Value *result)
 {
+  if (IS_NULL(left) || IS_NULL(right))
+    {
+      result->dt = DT_NULL;
+      return RC_OK;
+    }
   if(left->dt != right->dt)
     THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "equality comparison only supported for values of the same datatype");
 
@@ -28,6 +34,8 @@ valueEquals (Value *left, Value *right, Value *result)
   case DT_STRING:
     result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) == 0);
     break;
+  default:
+    break;
   }
 
   return RC_OK;
@@ -36,6 +44,11 @@ valueEquals (Value *left, Value *right, Value *result)
 RC 
 valueSmaller (Value *left, Value *right, Value *result)
 {
+  if (IS_NULL(left) || IS_NULL(right))
+    {
+      result->dt = DT_NULL;
+      return RC_OK;
+    }
   if(left->dt != right->dt)
     THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "equality comparison only supported for values of the same datatype");
 
@@ -53,6 +66,8 @@ valueSmaller (Value *left, Value *right, Value *result)
   case DT_STRING:
     result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
     break;
+  default:
+    break;
   }
 
   return RC_OK;
@@ -61,6 +76,11 @@ valueSmaller (Value *left, Value *right, Value *result)
 RC 
 boolNot (Value *input, Value *result)
 {
+  if (IS_NULL(input))
+    {
+      result->dt = DT_NULL;
+      return RC_OK;
+    }
   if (input->dt != DT_BOOL)
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean NOT requires boolean input");
   result->dt = DT_BOOL;
@@ -69,12 +89,20 @@ boolNot (Value *input, Value *result)
   return RC_OK;
 }
 
+// a NULL input of AND and OR is unknown: false AND NULL is false and
+// true OR NULL is true, otherwise the result is NULL
 RC
 boolAnd (Value *left, Value *right, Value *result)
 {
-  if (left->dt != DT_BOOL || right->dt != DT_BOOL)
+  if ((left->dt != DT_BOOL && !IS_NULL(left)) || (right->dt != DT_BOOL && !IS_NULL(right)))
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
-  result->v.boolV = (left->v.boolV && right->v.boolV);
+  result->dt = DT_BOOL;
+  if ((left->dt == DT_BOOL && !left->v.boolV) || (right->dt == DT_BOOL && !right->v.boolV))
+    result->v.boolV = FALSE;
+  else if (IS_NULL(left) || IS_NULL(right))
+    result->dt = DT_NULL;
+  else
+    result->v.boolV = TRUE;
 
   return RC_OK;
 }
@@ -82,9 +110,15 @@ boolAnd (Value *left, Value *right, Value *result)
 RC
 boolOr (Value *left, Value *right, Value *result)
 {
-  if (left->dt != DT_BOOL || right->dt != DT_BOOL)
+  if ((left->dt != DT_BOOL && !IS_NULL(left)) || (right->dt != DT_BOOL && !IS_NULL(right)))
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
-  result->v.boolV = (left->v.boolV || right->v.boolV);
+  result->dt = DT_BOOL;
+  if ((left->dt == DT_BOOL && left->v.boolV) || (right->dt == DT_BOOL && right->v.boolV))
+    result->v.boolV = TRUE;
+  else if (IS_NULL(left) || IS_NULL(right))
+    result->dt = DT_NULL;
+  else
+    result->v.boolV = FALSE;
 
   return RC_OK;
 }
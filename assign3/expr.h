@@ -55,7 +55,7 @@ extern void freeVal(Value *val);
       (_result)->v.intV = _input->v.intV;					\
       break;								\
     case DT_STRING:							\
-      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV));	\
+      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV) + 1);	\
       strcpy((_result)->v.stringV, _input->v.stringV);			\
       break;								\
     case DT_FLOAT:							\
@@ -64,6 +64,9 @@ extern void freeVal(Value *val);
     case DT_BOOL:							\
       (_result)->v.boolV = _input->v.boolV;				\
       break;								\
+    case DT_NULL:							\
+    default:								\
+      break;								\
     }									\
 } while(0)
 
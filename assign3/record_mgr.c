@@ -5,113 +5,1394 @@
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 
-// Simple table management structure
+// Page 0 of a table file holds the table header and page 1 the root of
+// the free space map. The remaining pages form groups of FSM_GROUP_PAGES:
+// an FSM leaf page followed by the slotted data pages it describes.
+#define TABLE_HEADER_PAGE 0
+#define FSM_ROOT_PAGE 1
+#define FIRST_GROUP_PAGE 2
+#define TABLE_MAGIC 0x34424154 // "TAB4"
+
+// The header page starts with a TableHeader. The schema follows it: the
+// data type, type length and nullable flag of each of the numAttr
+// attributes, keySize key attribute numbers, and the attribute names as
+// NUL-terminated strings.
+typedef struct TableHeader
+{
+    int magic;
+    int recordSize;
+    int tupleCount;
+    int numPages;      // pages of the file, including the header page
+    int firstFreePage; // data page the next insert tries first, or NO_PAGE
+    int fsmRoot;       // root page of the free space map
+    int numAttr;
+    int keySize;
+    int aligned; // the records use the aligned layout
+} TableHeader;
+
+// Free space map. An FSM page is a binary max-tree of bytes kept in an
+// array: node i has the children 2i + 1 and 2i + 2, and the FSM_LEAVES
+// leaves come last. A leaf of a leaf page holds the free space category of
+// one data page, its free bytes in units of FSM_UNIT; a leaf of the root
+// holds the top node of one leaf page. Categories round free space down
+// and requests up, so a page found in the map always has room. Finding a
+// page descends both trees, whatever the size of the table.
+#define FSM_LEAVES (PAGE_SIZE / 2)
+#define FSM_UNIT (PAGE_SIZE / 256)
+#define FSM_MAX_CATEGORY 255
+#define FSM_GROUP_PAGES (FSM_LEAVES + 1)
+
+// A data page starts with a PageHeader followed by the slot directory,
+// which grows towards the end of the page. Records are packed at the tail
+// and grow towards the start; freeSpace is the offset of the lowest
+// record, so the gap between the directory and freeSpace is free.
+// Deleted records stay in place as holes until the page is compacted,
+// which frees their slots for reuse.
+typedef struct PageHeader
+{
+    int numSlots;
+    int freeSpace;
+    int holeBytes; // bytes of deleted records not yet compacted away
+    int freeSlots; // slots with offset 0, free for new records
+} PageHeader;
+
+typedef struct Slot
+{
+    unsigned short offset;
+    unsigned short length;
+} Slot;
+
+// The last byte of a stored record, after the fixed-size part and the
+// bytes of its VARCHARs, marks deleted records; their slot keeps its
+// number so other RIDs remain stable
+#define TOMBSTONE_LIVE 0
+#define TOMBSTONE_DELETED 1
+
+// Records of a schema with the aligned layout start at, and take, a
+// multiple of RECORD_ALIGNMENT bytes, so their attributes stay aligned
+// on the page
+#define RECORD_ALIGNMENT ((int)sizeof(int))
+
+// Bookkeeping of a table, registered by name
 typedef struct TableInfo
 {
-    BM_BufferPool dataPool;
-    int tupleCount;
-    int scanIndex;
-    Schema *schema;
-} TableInfo;
+    char *name;
+    struct TableInfo *next; // next table in the registry bucket
+    int refCount;           // openTable calls not yet closed
+    BM_BufferPool dataPool; // attached to the shared pool while open
+    int tupleCount;
+    int numPages;
+    int recordSize;
+    PageNumber firstFreePage;
+    PageNumber fsmRoot;
+    Schema *schema; // decoded from the header page
+} TableInfo;
+
+// Position of a scan
+typedef struct ScanInfo
+{
+    Expr *cond;
+    PageNumber page;
+    int slot;
+    BM_PageHandle viewPage; // page of the last view returned by nextView
+    bool viewPinned;        // viewPage is pinned and latched
+} ScanInfo;
+
+// State of bulkLoadTable: the run of pages formatted but not written yet
+// and the map of the group being filled, written once the group is done
+typedef struct BulkLoader
+{
+    SM_FileHandle fileHandle;
+    TableInfo table; // counters of the new table
+    char *run;
+    int runPages;
+    int maxRunPages;
+    PageNumber runStart; // page number of the first page of the run
+    char *page;          // data page being filled, the last of the run
+    unsigned char leaf[PAGE_SIZE];
+    unsigned char root[PAGE_SIZE];
+} BulkLoader;
+
+// Pages formatted in memory before each write of bulkLoadTable, unless
+// its options ask for a different number
+#define BULK_PAGES_PER_WRITE 256
+
+// Frames of the buffer pool shared by all tables, unless initRecordManager
+// is passed a different size
+#define MAX_BUFFER_SIZE 100
+
+// Registry of the open tables, a hash map from the table name to its
+// TableInfo with chained buckets
+#define TABLE_REGISTRY_BUCKETS 64
+
+TableInfo *tableRegistry[TABLE_REGISTRY_BUCKETS];
+
+// One buffer pool for the whole database, every open table attaches to it
+BM_BufferPool sharedPool;
+bool sharedPoolOpen = false;
+
+// Returns the registry link that points to a table, or the NULL link at
+// the end of the table's bucket
+static TableInfo **registryLink(const char *name)
+{
+    unsigned hash = 5381;
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        hash = hash * 33 + (unsigned char)*c;
+    }
+
+    TableInfo **link = &tableRegistry[hash % TABLE_REGISTRY_BUCKETS];
+    while (*link != NULL && strcmp((*link)->name, name) != 0)
+    {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+// Removes a table from the registry and frees its bookkeeping
+static void unregisterTable(TableInfo **link)
+{
+    TableInfo *mgr = *link;
+    *link = mgr->next;
+    if (mgr->schema != NULL)
+    {
+        freeSchema(mgr->schema);
+    }
+    free(mgr->name);
+    free(mgr);
+}
+
+// Returns the header of a data page
+static PageHeader *pageHeader(char *data)
+{
+    return (PageHeader *)data;
+}
+
+// Returns a slot of the directory of a data page
+static Slot *slotAt(char *data, int slot)
+{
+    return (Slot *)(data + sizeof(PageHeader)) + slot;
+}
+
+// Returns the bytes between the slot directory and the records of a page
+static int pageFreeSpace(char *data)
+{
+    PageHeader *header = pageHeader(data);
+    return header->freeSpace - (int)(sizeof(PageHeader) + header->numSlots * sizeof(Slot));
+}
+
+// Pins a page of a table and takes its content latch
+static RC pinTablePage(TableInfo *mgr, BM_PageHandle *page, PageNumber pageNum, bool exclusive)
+{
+    RC result = pinPage(&mgr->dataPool, page, pageNum);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    result = exclusive ? latchPageExclusive(&mgr->dataPool, page) : latchPageShared(&mgr->dataPool, page);
+    if (result != RC_OK)
+    {
+        unpinPage(&mgr->dataPool, page);
+    }
+    return result;
+}
+
+// Releases the latch and the pin taken by pinTablePage
+static RC releaseTablePage(TableInfo *mgr, BM_PageHandle *page, bool dirty)
+{
+    if (dirty)
+    {
+        markDirty(&mgr->dataPool, page);
+    }
+    unlatchPage(&mgr->dataPool, page);
+    return unpinPage(&mgr->dataPool, page);
+}
+
+// Finds the live record of a RID on a page latched by the caller
+static char *recordAt(TableInfo *mgr, char *data, RID id)
+{
+    if (id.slot < 0 || id.slot >= pageHeader(data)->numSlots)
+    {
+        return NULL;
+    }
+    Slot *slot = slotAt(data, id.slot);
+    if (slot->offset == 0 || slot->length > mgr->recordSize)
+    {
+        return NULL;
+    }
+    char *record = data + slot->offset;
+    return (record[slot->length - 1] == TOMBSTONE_LIVE) ? record : NULL;
+}
+
+// Checks whether a page holds tuples rather than the header or the FSM
+static bool isDataPage(PageNumber pageNum)
+{
+    return pageNum > FIRST_GROUP_PAGE && (pageNum - FIRST_GROUP_PAGE) % FSM_GROUP_PAGES != 0;
+}
+
+// Checks that a RID names a data page of the table
+static bool validPage(TableInfo *mgr, RID id)
+{
+    return isDataPage(id.page) && id.page < mgr->numPages;
+}
+
+// Returns the largest record a page can take, counting the holes that
+// compaction would reclaim and a new slot
+static int pageAvailable(char *data)
+{
+    int available = pageFreeSpace(data) + pageHeader(data)->holeBytes - (int)sizeof(Slot);
+    return (available > 0) ? available : 0;
+}
+
+// Packs the live records at the tail of a page and frees the slots of
+// deleted ones; slot numbers, and therefore RIDs, do not change
+static void compactPage(char *data)
+{
+    PageHeader *header = pageHeader(data);
+    char packed[PAGE_SIZE];
+    int offset = PAGE_SIZE;
+
+    for (int i = 0; i < header->numSlots; i++)
+    {
+        Slot *slot = slotAt(data, i);
+        if (slot->offset == 0)
+        {
+            continue;
+        }
+        if (data[slot->offset + slot->length - 1] != TOMBSTONE_LIVE)
+        {
+            slot->offset = 0;
+            slot->length = 0;
+            header->freeSlots++;
+            continue;
+        }
+        offset -= slot->length;
+        memcpy(packed + offset, data + slot->offset, slot->length);
+        slot->offset = offset;
+    }
+    memcpy(data + offset, packed + offset, PAGE_SIZE - offset);
+    header->freeSpace = offset;
+    header->holeBytes = 0;
+}
+
+// Stores a record of the given length on a page with room for it,
+// returns its slot
+static int placeRecord(char *data, char *record, int length)
+{
+    PageHeader *header = pageHeader(data);
+    int slotNum = header->numSlots;
+    int needed = length + ((header->freeSlots > 0) ? 0 : (int)sizeof(Slot));
+
+    if (pageFreeSpace(data) < needed)
+    {
+        compactPage(data);
+    }
+    if (header->freeSlots > 0)
+    {
+        for (slotNum = 0; slotAt(data, slotNum)->offset != 0; slotNum++)
+            ;
+        header->freeSlots--;
+    }
+    else
+    {
+        header->numSlots++;
+    }
+
+    Slot *slot = slotAt(data, slotNum);
+    header->freeSpace -= length;
+    slot->offset = header->freeSpace;
+    slot->length = length;
+    memcpy(data + slot->offset, record, length);
+    data[slot->offset + length - 1] = TOMBSTONE_LIVE;
+    return slotNum;
+}
+
+// Stores a new version of a record under its slot, away from the old
+// one, which becomes a hole; the page must have room for it
+static void moveRecord(char *data, int slotNum, char *record, int length)
+{
+    PageHeader *header = pageHeader(data);
+    Slot *slot = slotAt(data, slotNum);
+
+    data[slot->offset + slot->length - 1] = TOMBSTONE_DELETED;
+    header->holeBytes += slot->length;
+    if (pageFreeSpace(data) < length)
+    {
+        compactPage(data); // frees the slot along with the old version
+        header->freeSlots--;
+    }
+    header->freeSpace -= length;
+    slot->offset = header->freeSpace;
+    slot->length = length;
+    memcpy(data + slot->offset, record, length);
+    data[slot->offset + length - 1] = TOMBSTONE_LIVE;
+}
+
+// Returns the FSM leaf page describing a group of data pages
+static PageNumber fsmLeafPage(int group)
+{
+    return FIRST_GROUP_PAGE + group * FSM_GROUP_PAGES;
+}
+
+// Sets a leaf of an FSM page and the nodes above it, returns the top node
+static int fsmSetLeaf(unsigned char *tree, int leaf, int category)
+{
+    int node = FSM_LEAVES - 1 + leaf;
+
+    tree[node] = (unsigned char)category;
+    while (node > 0)
+    {
+        node = (node - 1) / 2;
+        unsigned char left = tree[2 * node + 1], right = tree[2 * node + 2];
+        unsigned char top = (left > right) ? left : right;
+        if (tree[node] == top)
+        {
+            break;
+        }
+        tree[node] = top;
+    }
+    return tree[0];
+}
+
+// Returns the leftmost leaf of an FSM page of at least a category, or -1
+static int fsmSearch(unsigned char *tree, int category)
+{
+    int node = 0;
+
+    if (tree[0] < category)
+    {
+        return -1;
+    }
+    while (node < FSM_LEAVES - 1)
+    {
+        node = (tree[2 * node + 1] >= category) ? 2 * node + 1 : 2 * node + 2;
+    }
+    return node - (FSM_LEAVES - 1);
+}
+
+// Returns the category of a page's free space, rounded down
+static int fsmCategory(int available)
+{
+    int category = available / FSM_UNIT;
+    return (category > FSM_MAX_CATEGORY) ? FSM_MAX_CATEGORY : category;
+}
+
+// Records the free space of a data page in the map
+static RC fsmUpdate(TableInfo *mgr, PageNumber pageNum, int available)
+{
+    int group = (pageNum - FIRST_GROUP_PAGE) / FSM_GROUP_PAGES;
+    int leaf = (pageNum - FIRST_GROUP_PAGE) % FSM_GROUP_PAGES - 1;
+    int category = fsmCategory(available);
+    BM_PageHandle page;
+
+    RC result = pinTablePage(mgr, &page, fsmLeafPage(group), true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    unsigned char *tree = (unsigned char *)page.data;
+    int oldTop = tree[0], top = oldTop;
+    bool changed = tree[FSM_LEAVES - 1 + leaf] != category;
+    if (changed)
+    {
+        top = fsmSetLeaf(tree, leaf, category);
+    }
+    result = releaseTablePage(mgr, &page, changed);
+    if (result != RC_OK || top == oldTop)
+    {
+        return result;
+    }
+
+    // The best page of the group changed, so does the group's root entry
+    result = pinTablePage(mgr, &page, mgr->fsmRoot, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    fsmSetLeaf((unsigned char *)page.data, group, top);
+    return releaseTablePage(mgr, &page, true);
+}
+
+// Looks up a data page that can take a record of the given size; NO_PAGE
+// if no page in the map has room
+static RC fsmFind(TableInfo *mgr, int size, PageNumber *pageNum)
+{
+    int category = (size + FSM_UNIT - 1) / FSM_UNIT;
+    BM_PageHandle page;
+
+    *pageNum = NO_PAGE;
+    if (category > FSM_MAX_CATEGORY)
+    {
+        return RC_OK;
+    }
+    RC result = pinTablePage(mgr, &page, mgr->fsmRoot, false);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    int group = fsmSearch((unsigned char *)page.data, category);
+    releaseTablePage(mgr, &page, false);
+    if (group < 0)
+    {
+        return RC_OK;
+    }
+
+    result = pinTablePage(mgr, &page, fsmLeafPage(group), false);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    int leaf = fsmSearch((unsigned char *)page.data, category);
+    releaseTablePage(mgr, &page, false);
+    if (leaf >= 0)
+    {
+        *pageNum = fsmLeafPage(group) + 1 + leaf;
+    }
+    return RC_OK;
+}
+
+// Appends a formatted, empty data page to the table, starting a new FSM
+// group first when the next page belongs to one
+static RC appendDataPage(TableInfo *mgr, BM_PageHandle *page)
+{
+    PageNumber pageNum = mgr->numPages;
+    RC result;
+
+    if (!isDataPage(pageNum))
+    {
+        if ((pageNum - FIRST_GROUP_PAGE) / FSM_GROUP_PAGES >= FSM_LEAVES)
+        {
+            return RC_WRITE_FAILED; // the map covers FSM_LEAVES groups
+        }
+        // Pinning a page past the end grows the file
+        result = pinTablePage(mgr, page, pageNum, true);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        memset(page->data, 0, PAGE_SIZE);
+        result = releaseTablePage(mgr, page, true);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        mgr->numPages = ++pageNum;
+    }
+
+    result = pinTablePage(mgr, page, pageNum, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    mgr->numPages = pageNum + 1;
+    memset(page->data, 0, PAGE_SIZE);
+    pageHeader(page->data)->freeSpace = PAGE_SIZE;
+    return RC_OK;
+}
+
+// Pins and latches a data page with room for a record of the given
+// length: the page of the last insert or the lowest delete usually has
+// room, otherwise the map names one; without one a page is appended
+static RC pinInsertPage(TableInfo *mgr, BM_PageHandle *page, int length)
+{
+    PageNumber pageNum = mgr->firstFreePage;
+    RC result;
+
+    if (pageNum != NO_PAGE)
+    {
+        result = pinTablePage(mgr, page, pageNum, true);
+        if (result != RC_OK || pageAvailable(page->data) >= length)
+        {
+            return result;
+        }
+        releaseTablePage(mgr, page, false);
+    }
+
+    for (;;)
+    {
+        result = fsmFind(mgr, length, &pageNum);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        if (pageNum == NO_PAGE)
+        {
+            return appendDataPage(mgr, page);
+        }
+        result = pinTablePage(mgr, page, pageNum, true);
+        if (result != RC_OK || pageAvailable(page->data) >= length)
+        {
+            return result;
+        }
+
+        // The map was out of date; correct it and look again
+        int available = pageAvailable(page->data);
+        releaseTablePage(mgr, page, false);
+        result = fsmUpdate(mgr, pageNum, available);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+    }
+}
+
+// Encodes a table header and its schema into a header page, returns
+// false if the schema does not fit
+static bool encodeTableHeader(TableHeader *header, Schema *schema, char *data)
+{
+    int size = sizeof(TableHeader) + (3 * schema->numAttr + schema->keySize) * sizeof(int);
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        size += strlen(schema->attrNames[i]) + 1;
+    }
+    if (size > PAGE_SIZE)
+    {
+        return false;
+    }
+
+    header->numAttr = schema->numAttr;
+    header->keySize = schema->keySize;
+    header->aligned = schema->aligned;
+    memcpy(data, header, sizeof(TableHeader));
+    int *ints = (int *)(data + sizeof(TableHeader));
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        *ints++ = schema->dataTypes[i];
+        *ints++ = schema->typeLength[i];
+        *ints++ = schema->nullable[i];
+    }
+    for (int i = 0; i < schema->keySize; i++)
+    {
+        *ints++ = schema->keyAttrs[i];
+    }
+    char *names = (char *)ints;
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        strcpy(names, schema->attrNames[i]);
+        names += strlen(names) + 1;
+    }
+    return true;
+}
+
+// Rebuilds the schema stored in a header page, NULL if the page does not
+// hold a valid one
+static Schema *decodeSchema(TableHeader *header, char *data)
+{
+    int numAttr = header->numAttr, keySize = header->keySize;
+    if (header->magic != TABLE_MAGIC || numAttr <= 0 || keySize < 0 ||
+        sizeof(TableHeader) + (3 * numAttr + keySize) * sizeof(int) + numAttr > PAGE_SIZE)
+    {
+        return NULL;
+    }
+
+    char **attrNames = (char **)malloc(numAttr * sizeof(char *));
+    DataType *dataTypes = (DataType *)malloc(numAttr * sizeof(DataType));
+    int *typeLength = (int *)malloc(numAttr * sizeof(int));
+    bool *nullable = (bool *)malloc(numAttr * sizeof(bool));
+    Schema *schema = NULL;
+    if (attrNames != NULL && dataTypes != NULL && typeLength != NULL && nullable != NULL)
+    {
+        int *ints = (int *)(data + sizeof(TableHeader));
+        for (int i = 0; i < numAttr; i++)
+        {
+            dataTypes[i] = (DataType)*ints++;
+            typeLength[i] = *ints++;
+            nullable[i] = (*ints++ != 0);
+        }
+        int *keys = ints;
+
+        // The names point into the page, createSchema copies them
+        char *name = (char *)(keys + keySize);
+        char *end = data + PAGE_SIZE;
+        int i;
+        for (i = 0; i < numAttr && name < end; i++)
+        {
+            attrNames[i] = name;
+            name += strnlen(name, end - name) + 1;
+        }
+        if (i == numAttr && name <= end)
+        {
+            schema = createNullableSchema(numAttr, attrNames, dataTypes, typeLength, nullable, keySize, keys);
+        }
+        if (schema != NULL && header->aligned)
+        {
+            alignSchema(schema);
+        }
+    }
+    free(attrNames);
+    free(dataTypes);
+    free(typeLength);
+    free(nullable);
+
+    if (schema != NULL && getRecordSize(schema) != header->recordSize)
+    {
+        freeSchema(schema);
+        schema = NULL;
+    }
+    return schema;
+}
+
+// Writes the in-memory counters back to the header page; the schema
+// after them does not change
+static RC writeTableHeader(TableInfo *mgr)
+{
+    BM_PageHandle page;
+
+    RC result = pinTablePage(mgr, &page, TABLE_HEADER_PAGE, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    TableHeader *header = (TableHeader *)page.data;
+    header->tupleCount = mgr->tupleCount;
+    header->numPages = mgr->numPages;
+    header->firstFreePage = mgr->firstFreePage;
+    return releaseTablePage(mgr, &page, true);
+}
+
+// Writes the header and detaches the table's file from the shared pool
+static RC detachTable(TableInfo *mgr)
+{
+    RC result = writeTableHeader(mgr);
+    RC detached = shutdownBufferPool(&mgr->dataPool);
+    return (result != RC_OK) ? result : detached;
+}
+
+// Bytes of an attribute's value, or of its reference for a VARCHAR; -1
+// for an unknown type
+static int attrSize(Schema *schema, int attrNum)
+{
+    switch (schema->dataTypes[attrNum])
+    {
+    case DT_STRING:
+        return schema->typeLength[attrNum];
+    case DT_INT:
+        return sizeof(int);
+    case DT_FLOAT:
+        return sizeof(float);
+    case DT_BOOL:
+        return sizeof(bool);
+    case DT_VARCHAR:
+        return sizeof(VarcharRef);
+    default:
+        return -1;
+    }
+}
+
+// Checks whether the fixed-size part of a record holds an attribute;
+// nullable attributes of a fixed size follow it, and only take bytes
+// while they are not NULL
+static bool storedInline(Schema *schema, int attrNum)
+{
+    return !schema->nullable[attrNum] || schema->dataTypes[attrNum] == DT_VARCHAR;
+}
+
+// Alignment of an attribute in the aligned layout
+static int attrAlignment(Schema *schema, int attrNum)
+{
+    switch (schema->dataTypes[attrNum])
+    {
+    case DT_INT:
+        return sizeof(int);
+    case DT_FLOAT:
+        return sizeof(float);
+    case DT_BOOL:
+        return sizeof(bool);
+    case DT_VARCHAR:
+        return sizeof(unsigned short);
+    default:
+        return 1;
+    }
+}
+
+// Rounds an offset up to a multiple of an alignment
+static int alignUp(int offset, int alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Bytes a nullable attribute stored after the fixed-size part takes while
+// it is set; in the aligned layout every one keeps the next aligned
+static int detachedSize(Schema *schema, int attrNum)
+{
+    int size = attrSize(schema, attrNum);
+    return schema->aligned ? alignUp(size, RECORD_ALIGNMENT) : size;
+}
+
+// Computes the offsets of the attributes in the fixed-size part of a
+// record once, so that finding an attribute does not add up the sizes of
+// the ones before it. The null bitmap, one bit per attribute, leads the
+// records of a schema with nullable attributes.
+static void computeLayout(Schema *schema)
+{
+    int offset = 0;
+
+    schema->varLength = false;
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (schema->nullable[i])
+        {
+            offset = (schema->numAttr + 7) / 8;
+            schema->varLength = true;
+        }
+    }
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (schema->dataTypes[i] == DT_VARCHAR)
+        {
+            schema->varLength = true;
+        }
+        if (!storedInline(schema, i))
+        {
+            schema->attrOffsets[i] = -1;
+            continue;
+        }
+        if (schema->aligned)
+        {
+            offset = alignUp(offset, attrAlignment(schema, i));
+        }
+        schema->attrOffsets[i] = offset;
+        offset += attrSize(schema, i);
+    }
+    schema->fixedSize = schema->aligned ? alignUp(offset, RECORD_ALIGNMENT) : offset;
+}
+
+// Checks the null bit of an attribute
+static bool attrIsNull(Schema *schema, char *data, int attrNum)
+{
+    return schema->nullable[attrNum] && (data[attrNum / 8] & (1 << (attrNum % 8))) != 0;
+}
 
-#define MAX_BUFFER_SIZE 100
+// Sets or clears the null bit of an attribute
+static void setNullBit(char *data, int attrNum, bool isNull)
+{
+    if (isNull)
+    {
+        data[attrNum / 8] |= (char)(1 << (attrNum % 8));
+    }
+    else
+    {
+        data[attrNum / 8] &= (char)~(1 << (attrNum % 8));
+    }
+}
+
+// Byte offset of the value of an attribute in a record; a nullable one
+// of a fixed size comes after the nullable ones before it that are set
+static int valueOffset(Schema *schema, char *data, int attrNum)
+{
+    if (storedInline(schema, attrNum))
+    {
+        return schema->attrOffsets[attrNum];
+    }
+    int offset = schema->fixedSize;
+    for (int i = 0; i < attrNum; i++)
+    {
+        if (!storedInline(schema, i) && !attrIsNull(schema, data, i))
+        {
+            offset += detachedSize(schema, i);
+        }
+    }
+    return offset;
+}
+
+// Returns the end of the bytes of a record: the fixed-size part, the
+// nullable values that are set, then the VARCHAR bytes
+static int recordEnd(Schema *schema, char *data)
+{
+    int end = schema->fixedSize;
+    if (!schema->varLength)
+    {
+        return end;
+    }
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (!storedInline(schema, i) && !attrIsNull(schema, data, i))
+        {
+            end += detachedSize(schema, i);
+        }
+    }
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (schema->dataTypes[i] == DT_VARCHAR)
+        {
+            VarcharRef ref;
+            memcpy(&ref, data + schema->attrOffsets[i], sizeof(VarcharRef));
+            if (ref.length > 0 && ref.offset + ref.length > end)
+            {
+                end = ref.offset + ref.length;
+            }
+        }
+    }
+    return end;
+}
+
+// Returns the bytes a record takes on a page, tombstone included; aligned
+// records keep the next record on the page aligned
+static int recordLength(Schema *schema, char *data)
+{
+    int length = recordEnd(schema, data) + 1;
+    return schema->aligned ? alignUp(length, RECORD_ALIGNMENT) : length;
+}
+
+// Moves the bytes of a record from an offset on by delta bytes, making
+// room for a value or closing the gap it leaves, and updates the VARCHAR
+// references to the bytes that moved
+static void shiftRecordBytes(Schema *schema, char *data, int from, int delta)
+{
+    memmove(data + from + delta, data + from, recordEnd(schema, data) - from);
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        VarcharRef ref;
+        char *refData = data + schema->attrOffsets[i];
+        if (schema->dataTypes[i] != DT_VARCHAR)
+        {
+            continue;
+        }
+        memcpy(&ref, refData, sizeof(VarcharRef));
+        if (ref.length > 0 && ref.offset >= from)
+        {
+            ref.offset += delta;
+            memcpy(refData, &ref, sizeof(VarcharRef));
+        }
+    }
+}
+
+// Replaces the bytes of a VARCHAR: the old bytes are cut out and the new
+// ones appended, so the bytes of a record stay packed. Strings longer
+// than the attribute are truncated.
+static void setVarchar(Schema *schema, char *data, int attrNum, char *string)
+{
+    char *refData = data + schema->attrOffsets[attrNum];
+    VarcharRef ref;
+
+    memcpy(&ref, refData, sizeof(VarcharRef));
+    if (ref.length > 0)
+    {
+        shiftRecordBytes(schema, data, ref.offset + ref.length, -ref.length);
+        ref.length = 0;
+        memcpy(refData, &ref, sizeof(VarcharRef));
+    }
+
+    ref.offset = recordEnd(schema, data);
+    ref.length = strnlen(string, schema->typeLength[attrNum]);
+    memcpy(data + ref.offset, string, ref.length);
+    memcpy(refData, &ref, sizeof(VarcharRef));
+}
+
+// Makes an attribute NULL and drops the bytes of its value
+static void setAttrNull(Schema *schema, char *data, int attrNum)
+{
+    if (attrIsNull(schema, data, attrNum))
+    {
+        return;
+    }
+    if (schema->dataTypes[attrNum] == DT_VARCHAR)
+    {
+        setVarchar(schema, data, attrNum, "");
+    }
+    else if (!storedInline(schema, attrNum))
+    {
+        int size = detachedSize(schema, attrNum);
+        shiftRecordBytes(schema, data, valueOffset(schema, data, attrNum) + size, -size);
+    }
+    setNullBit(data, attrNum, true);
+}
+
+// Makes room for the value of a NULL attribute about to be set
+static void clearAttrNull(Schema *schema, char *data, int attrNum)
+{
+    if (!attrIsNull(schema, data, attrNum))
+    {
+        return;
+    }
+    if (!storedInline(schema, attrNum))
+    {
+        shiftRecordBytes(schema, data, valueOffset(schema, data, attrNum), detachedSize(schema, attrNum));
+    }
+    setNullBit(data, attrNum, false);
+}
+
+// Parses a line of delimited text into a record; fields are typed like
+// stringToValue types its input, without allocating a Value per field
+static RC parseRecord(Schema *schema, char *line, char delimiter, Record *record)
+{
+    char *field = line;
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (field == NULL)
+        {
+            return RC_INVALID_PARAMETER; // too few fields
+        }
+        char *end = strchr(field, delimiter);
+        if (end != NULL)
+        {
+            *end = '\0';
+        }
+
+        Value value;
+        value.dt = schema->dataTypes[i];
+        if (field[0] == '\0' && schema->nullable[i])
+        {
+            value.dt = DT_NULL; // an empty field of a nullable attribute
+        }
+        switch (value.dt)
+        {
+        case DT_NULL:
+            break;
+        case DT_INT:
+            value.v.intV = atoi(field);
+            break;
+        case DT_FLOAT:
+            value.v.floatV = atof(field);
+            break;
+        case DT_BOOL:
+            value.v.boolV = (field[0] == 't') ? TRUE : FALSE;
+            break;
+        case DT_STRING:
+        case DT_VARCHAR:
+            value.dt = DT_STRING;
+            value.v.stringV = field;
+            break;
+        default:
+            return RC_RM_UNKOWN_DATATYPE;
+        }
+        RC result = setAttr(record, schema, i, &value);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        field = (end != NULL) ? end + 1 : NULL;
+    }
+    return (field == NULL) ? RC_OK : RC_INVALID_PARAMETER; // too many fields
+}
+
+// Writes the run of formatted pages with one request
+static RC bulkFlush(BulkLoader *loader)
+{
+    if (loader->runPages == 0)
+    {
+        return RC_OK;
+    }
+    RC result = writeBlocks(loader->runStart, loader->runPages, &loader->fileHandle, loader->run);
+    loader->runStart += loader->runPages;
+    loader->runPages = 0;
+    return result;
+}
+
+// Adds a zeroed page to the run, writing the run first when it is full
+static RC bulkNewPage(BulkLoader *loader, char **data)
+{
+    if (loader->runPages == loader->maxRunPages)
+    {
+        RC result = bulkFlush(loader);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+    }
+    *data = loader->run + loader->runPages++ * PAGE_SIZE;
+    memset(*data, 0, PAGE_SIZE);
+    loader->table.numPages++;
+    return RC_OK;
+}
+
+// Enters the free space of the page being filled in the group's map
+static void bulkFinishPage(BulkLoader *loader)
+{
+    if (loader->page != NULL)
+    {
+        int leaf = (loader->table.firstFreePage - FIRST_GROUP_PAGE) % FSM_GROUP_PAGES - 1;
+        fsmSetLeaf(loader->leaf, leaf, fsmCategory(pageAvailable(loader->page)));
+        loader->page = NULL;
+    }
+}
+
+// Writes the map of the group of the last data page over the leaf page
+// reserved for it, and enters the group in the root
+static RC bulkFinishGroup(BulkLoader *loader)
+{
+    if (loader->table.firstFreePage == NO_PAGE)
+    {
+        return RC_OK;
+    }
+    int group = (loader->table.firstFreePage - FIRST_GROUP_PAGE) / FSM_GROUP_PAGES;
+    fsmSetLeaf(loader->root, group, loader->leaf[0]);
 
-TableInfo *tableInfo = NULL;
+    // The leaf page has to be in the file before it is overwritten
+    RC result = bulkFlush(loader);
+    if (result == RC_OK)
+    {
+        result = writeBlock(fsmLeafPage(group), &loader->fileHandle, (char *)loader->leaf);
+    }
+    memset(loader->leaf, 0, PAGE_SIZE);
+    return result;
+}
+
+// Starts a new data page, preceded by a leaf page when it opens a group
+static RC bulkAppendPage(BulkLoader *loader)
+{
+    PageNumber pageNum = loader->table.numPages;
+    char *data;
+    RC result;
+
+    bulkFinishPage(loader);
+    if (!isDataPage(pageNum))
+    {
+        if ((pageNum - FIRST_GROUP_PAGE) / FSM_GROUP_PAGES >= FSM_LEAVES)
+        {
+            return RC_WRITE_FAILED; // the map covers FSM_LEAVES groups
+        }
+        result = bulkFinishGroup(loader);
+        if (result == RC_OK)
+        {
+            result = bulkNewPage(loader, &data);
+        }
+        if (result != RC_OK)
+        {
+            return result;
+        }
+    }
+
+    result = bulkNewPage(loader, &data);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    pageHeader(data)->freeSpace = PAGE_SIZE;
+    loader->page = data;
+    loader->table.firstFreePage = loader->table.numPages - 1;
+    return RC_OK;
+}
+
+// Formats the records of an input into pages and writes them, followed by
+// the map and the counters of the header
+static RC bulkLoadRecords(BulkLoader *loader, Schema *schema, FILE *input, RM_BulkLoadOptions *options)
+{
+    Record *record;
+    RC result = createRecord(&record, schema);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    bool skip = options->skipHeader;
+    while (result == RC_OK && (length = getline(&line, &capacity, input)) >= 0)
+    {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        {
+            line[--length] = '\0';
+        }
+        if (skip)
+        {
+            skip = false;
+            continue;
+        }
+        if (length == 0)
+        {
+            continue;
+        }
+
+        result = parseRecord(schema, line, options->delimiter, record);
+        if (result != RC_OK)
+        {
+            break;
+        }
+        int recordSize = recordLength(schema, record->data);
+        if (loader->page == NULL || pageAvailable(loader->page) < recordSize)
+        {
+            result = bulkAppendPage(loader);
+        }
+        if (result == RC_OK)
+        {
+            placeRecord(loader->page, record->data, recordSize);
+            loader->table.tupleCount++;
+        }
+    }
+    free(line);
+    freeRecord(record);
+    if (result == RC_OK && ferror(input))
+    {
+        result = RC_ERROR;
+    }
+
+    bulkFinishPage(loader);
+    if (result == RC_OK)
+    {
+        result = bulkFinishGroup(loader);
+    }
+    if (result == RC_OK)
+    {
+        result = writeBlock(FSM_ROOT_PAGE, &loader->fileHandle, (char *)loader->root);
+    }
+
+    // The schema is in the header already, only the counters change
+    char page[PAGE_SIZE];
+    if (result == RC_OK)
+    {
+        result = readBlock(TABLE_HEADER_PAGE, &loader->fileHandle, page);
+    }
+    if (result == RC_OK)
+    {
+        TableHeader *header = (TableHeader *)page;
+        header->tupleCount = loader->table.tupleCount;
+        header->numPages = loader->table.numPages;
+        header->firstFreePage = loader->table.firstFreePage;
+        result = writeBlock(TABLE_HEADER_PAGE, &loader->fileHandle, page);
+    }
+    return result;
+}
+
+// Finds the next record of a scan on its current page, latched by the
+// caller, that satisfies the scan condition. The condition is evaluated
+// on the record in the page; found points to it there.
+static RC scanPage(RM_ScanHandle *scan, char *data, Record *found)
+{
+    ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+    TableInfo *mgr = (TableInfo *)scan->rel->mgmtData;
+
+    while (scanInfo->slot < pageHeader(data)->numSlots)
+    {
+        found->id.page = scanInfo->page;
+        found->id.slot = scanInfo->slot++;
+        found->data = recordAt(mgr, data, found->id);
+        if (found->data == NULL)
+        {
+            continue;
+        }
+        if (scanInfo->cond == NULL)
+        {
+            return RC_OK;
+        }
+
+        Value *value;
+        bool matches = false;
+        RC result = evalExpr(found, scan->rel->schema, scanInfo->cond, &value);
+        if (result == RC_OK)
+        {
+            if (value->dt == DT_BOOL)
+            {
+                matches = value->v.boolV;
+            }
+            else if (value->dt == DT_NULL)
+            {
+                matches = false; // unknown, like a WHERE clause
+            }
+            else
+            {
+                result = RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN;
+            }
+            freeVal(value);
+        }
+        if (result != RC_OK || matches)
+        {
+            return result;
+        }
+    }
+    return RC_RM_NO_MORE_TUPLES;
+}
 
 RC initRecordManager(void *mgmtData)
 {
     initStorageManager();
-    printf("Record manager initialized\n");
+
+    // mgmtData optionally points to the number of frames of the pool
+    int poolSize = (mgmtData != NULL) ? *(int *)mgmtData : MAX_BUFFER_SIZE;
+    if (!sharedPoolOpen)
+    {
+        RC result = initSharedBufferPool(&sharedPool, poolSize, RS_LRU, NULL);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        sharedPoolOpen = true;
+    }
+
     return RC_OK;
 }
 
 RC shutdownRecordManager()
 {
-    printf("Shutting down record manager\n");
-    if (tableInfo != NULL)
+    for (int i = 0; i < TABLE_REGISTRY_BUCKETS; i++)
     {
-        if (tableInfo->schema != NULL)
+        while (tableRegistry[i] != NULL)
         {
-            freeSchema(tableInfo->schema);
+            detachTable(tableRegistry[i]);
+            unregisterTable(&tableRegistry[i]);
         }
-        shutdownBufferPool(&tableInfo->dataPool);
-        free(tableInfo);
-        tableInfo = NULL;
+    }
+    if (sharedPoolOpen)
+    {
+        RC result = shutdownBufferPool(&sharedPool);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        sharedPoolOpen = false;
     }
     return RC_OK;
 }
 
 RC createTable(char *name, Schema *schema)
 {
-    printf("Creating table: %s\n", name);
     if (name == NULL || schema == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
+    int recordSize = getRecordSize(schema);
+    if (recordSize <= 0 || recordSize + sizeof(PageHeader) + sizeof(Slot) > PAGE_SIZE)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    if (*registryLink(name) != NULL)
+    {
+        return RC_ERROR;
+    }
+
+    // The header page carries the schema, the map starts out empty
+    TableHeader header = {TABLE_MAGIC, recordSize, 0, FIRST_GROUP_PAGE, NO_PAGE, FSM_ROOT_PAGE, 0, 0, 0};
+    char *page = (char *)calloc(1, PAGE_SIZE);
+    if (page == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+    if (!encodeTableHeader(&header, schema, page))
+    {
+        free(page);
+        return RC_INVALID_PARAMETER;
+    }
 
     RC result = createPageFile(name);
-    printf("Create page file result: %d\n", result);
+
+    // Write the pages straight to the new file
+    SM_FileHandle fileHandle;
+    if (result == RC_OK)
+    {
+        result = openPageFile(name, &fileHandle);
+    }
+    if (result == RC_OK)
+    {
+        result = ensureCapacity(FIRST_GROUP_PAGE, &fileHandle);
+        if (result == RC_OK)
+        {
+            result = writeBlock(TABLE_HEADER_PAGE, &fileHandle, page);
+        }
+        RC closed = closePageFile(&fileHandle);
+        if (result == RC_OK)
+        {
+            result = closed;
+        }
+    }
+    free(page);
     return result;
 }
 
 RC openTable(RM_TableData *rel, char *name)
 {
-    printf("Opening table: %s\n", name);
     if (rel == NULL || name == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
+    if (!sharedPoolOpen)
+    {
+        return RC_ERROR;
+    }
+
+    // A table that is open already shares its state
+    TableInfo **link = registryLink(name);
+    TableInfo *mgr = *link;
+    if (mgr == NULL)
+    {
+        mgr = (TableInfo *)calloc(1, sizeof(TableInfo));
+        if (mgr == NULL || (mgr->name = strdup(name)) == NULL)
+        {
+            free(mgr);
+            return RC_MEMORY_ALLOCATION_ERROR;
+        }
+        *link = mgr;
+
+        // Attach the table's page file to the shared buffer pool
+        RC result = attachBufferPool(&mgr->dataPool, &sharedPool, name);
+        if (result != RC_OK)
+        {
+            unregisterTable(link);
+            return result;
+        }
 
-    // Initialize table info if needed
-    if (tableInfo == NULL)
-    {
-        tableInfo = (TableInfo *)malloc(sizeof(TableInfo));
-        if (tableInfo == NULL)
+        // One read of the header page restores the counters and the
+        // schema; the counters stay in memory until the table is closed
+        BM_PageHandle page = {NO_PAGE, NULL};
+        TableHeader header;
+        result = pinTablePage(mgr, &page, TABLE_HEADER_PAGE, false);
+        if (result == RC_OK)
         {
-            return RC_MEMORY_ALLOCATION_ERROR;
+            memcpy(&header, page.data, sizeof(TableHeader));
+            mgr->schema = decodeSchema(&header, page.data);
+            if (mgr->schema == NULL)
+            {
+                result = RC_ERROR;
+            }
+            releaseTablePage(mgr, &page, false);
         }
-        
-        // Initialize buffer pool
-        RC result = initBufferPool(&tableInfo->dataPool, name, MAX_BUFFER_SIZE, RS_LRU, NULL);
         if (result != RC_OK)
         {
-            free(tableInfo);
-            tableInfo = NULL;
+            shutdownBufferPool(&mgr->dataPool);
+            unregisterTable(link);
             return result;
         }
-        
-        tableInfo->tupleCount = 0;
-        tableInfo->scanIndex = 0;
-        tableInfo->schema = NULL;
+
+        mgr->tupleCount = header.tupleCount;
+        mgr->numPages = header.numPages;
+        mgr->recordSize = header.recordSize;
+        mgr->firstFreePage = header.firstFreePage;
+        mgr->fsmRoot = header.fsmRoot;
     }
+    mgr->refCount++;
 
-    rel->mgmtData = tableInfo;
-    rel->name = name;
-    
-    // Store schema reference
-    tableInfo->schema = rel->schema;
+    rel->mgmtData = mgr;
+    rel->name = mgr->name;
+    rel->schema = mgr->schema;
 
-    printf("Table opened successfully. Tuple count: %d\n", tableInfo->tupleCount);
     return RC_OK;
 }
 
 RC closeTable(RM_TableData *rel)
 {
-    printf("Closing table\n");
     if (rel == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
-    return RC_OK;
+
+    TableInfo *mgr = (TableInfo *)rel->mgmtData;
+    if (mgr == NULL)
+    {
+        return RC_OK;
+    }
+    rel->mgmtData = NULL;
+
+    // The last close writes the header, detaches the file and drops the
+    // table from the registry
+    if (--mgr->refCount > 0)
+    {
+        return RC_OK;
+    }
+    RC result = detachTable(mgr);
+    unregisterTable(registryLink(mgr->name));
+    return result;
 }
 
 RC deleteTable(char *name)
 {
-    printf("Deleting table: %s\n", name);
     if (name == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
+    if (*registryLink(name) != NULL)
+    {
+        return RC_ERROR;
+    }
     return destroyPageFile(name);
 }
 
@@ -127,8 +1408,12 @@ int getNumTuples(RM_TableData *rel)
 
 RC insertRecord(RM_TableData *rel, Record *record)
 {
-    printf("Inserting record\n");
-    if (rel == NULL || record == NULL)
+    return insertRecords(rel, &record, 1);
+}
+
+RC insertRecords(RM_TableData *rel, Record **records, int n)
+{
+    if (rel == NULL || records == NULL || n < 0)
     {
         return RC_INVALID_PARAMETER;
     }
@@ -139,18 +1424,47 @@ RC insertRecord(RM_TableData *rel, Record *record)
         return RC_ERROR;
     }
 
-    // Simple implementation - just increment count and set basic RID
-    mgr->tupleCount++;
-    record->id.page = 1;
-    record->id.slot = mgr->tupleCount;
+    // Fill one page at a time: one pin, one latch and one map update per
+    // page rather than per record
+    int done = 0;
+    while (done < n)
+    {
+        BM_PageHandle page;
+        int length = recordLength(mgr->schema, records[done]->data);
+        RC result = pinInsertPage(mgr, &page, length);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+        while (pageAvailable(page.data) >= length)
+        {
+            records[done]->id.page = page.pageNum;
+            records[done]->id.slot = placeRecord(page.data, records[done]->data, length);
+            mgr->tupleCount++;
+            if (++done == n)
+            {
+                break;
+            }
+            length = recordLength(mgr->schema, records[done]->data);
+        }
+        mgr->firstFreePage = page.pageNum;
 
-    printf("Record inserted. New tuple count: %d\n", mgr->tupleCount);
+        int available = pageAvailable(page.data);
+        result = releaseTablePage(mgr, &page, true);
+        if (result == RC_OK)
+        {
+            result = fsmUpdate(mgr, page.pageNum, available);
+        }
+        if (result != RC_OK)
+        {
+            return result;
+        }
+    }
     return RC_OK;
 }
 
 RC deleteRecord(RM_TableData *rel, RID id)
 {
-    printf("Deleting record: page=%d, slot=%d\n", id.page, id.slot);
     if (rel == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -161,29 +1475,106 @@ RC deleteRecord(RM_TableData *rel, RID id)
     {
         return RC_ERROR;
     }
+    if (!validPage(mgr, id))
+    {
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
 
-    // Simple implementation
-    if (mgr->tupleCount > 0)
+    BM_PageHandle page;
+    RC result = pinTablePage(mgr, &page, id.page, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    char *data = recordAt(mgr, page.data, id);
+    if (data == NULL)
     {
-        mgr->tupleCount--;
+        releaseTablePage(mgr, &page, false);
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
     }
 
-    return RC_OK;
+    int length = slotAt(page.data, id.slot)->length;
+    data[length - 1] = TOMBSTONE_DELETED;
+    pageHeader(page.data)->holeBytes += length;
+    mgr->tupleCount--;
+    if (mgr->firstFreePage == NO_PAGE || id.page < mgr->firstFreePage)
+    {
+        mgr->firstFreePage = id.page;
+    }
+
+    int available = pageAvailable(page.data);
+    result = releaseTablePage(mgr, &page, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    return fsmUpdate(mgr, id.page, available);
 }
 
 RC updateRecord(RM_TableData *rel, Record *record)
 {
-    printf("Updating record: page=%d, slot=%d\n", record->id.page, record->id.slot);
     if (rel == NULL || record == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
-    return RC_OK;
+
+    TableInfo *mgr = (TableInfo *)rel->mgmtData;
+    if (mgr == NULL)
+    {
+        return RC_ERROR;
+    }
+    if (!validPage(mgr, record->id))
+    {
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+
+    BM_PageHandle page;
+    RC result = pinTablePage(mgr, &page, record->id.page, true);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    char *data = recordAt(mgr, page.data, record->id);
+    if (data == NULL)
+    {
+        releaseTablePage(mgr, &page, false);
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+
+    // A version that is not longer replaces the old one in place, the
+    // bytes it does not use become a hole. A longer one moves within the
+    // page, so the RID stays valid; it fails if the page has no room.
+    Slot *slot = slotAt(page.data, record->id.slot);
+    int oldLength = slot->length;
+    int length = recordLength(mgr->schema, record->data);
+    if (length <= oldLength)
+    {
+        memcpy(data, record->data, length - 1);
+        data[length - 1] = TOMBSTONE_LIVE;
+        slot->length = length;
+        pageHeader(page.data)->holeBytes += oldLength - length;
+    }
+    else if (pageFreeSpace(page.data) + pageHeader(page.data)->holeBytes + oldLength >= length)
+    {
+        moveRecord(page.data, record->id.slot, record->data, length);
+    }
+    else
+    {
+        releaseTablePage(mgr, &page, false);
+        return RC_RM_RECORD_DOES_NOT_FIT;
+    }
+
+    int available = pageAvailable(page.data);
+    result = releaseTablePage(mgr, &page, true);
+    if (result != RC_OK || length == oldLength)
+    {
+        return result;
+    }
+    return fsmUpdate(mgr, record->id.page, available);
 }
 
 RC getRecord(RM_TableData *rel, RID id, Record *record)
 {
-    printf("Getting record: page=%d, slot=%d\n", id.page, id.slot);
     if (rel == NULL || record == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -194,16 +1585,158 @@ RC getRecord(RM_TableData *rel, RID id, Record *record)
     {
         return RC_ERROR;
     }
+    if (!validPage(mgr, id))
+    {
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+
+    BM_PageHandle page;
+    RC result = pinTablePage(mgr, &page, id.page, false);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    char *data = recordAt(mgr, page.data, id);
+    if (data != NULL)
+    {
+        memcpy(record->data, data, slotAt(page.data, id.slot)->length);
+        record->id = id;
+    }
+    releaseTablePage(mgr, &page, false);
+
+    return (data != NULL) ? RC_OK : RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+}
+
+RC getRecordView(RM_TableData *rel, RID id, RecordView *view)
+{
+    if (rel == NULL || view == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    TableInfo *mgr = (TableInfo *)rel->mgmtData;
+    if (mgr == NULL)
+    {
+        return RC_ERROR;
+    }
+    if (!validPage(mgr, id))
+    {
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
 
-    // Simple implementation - just set the RID
-    record->id = id;
+    // The pin and the shared latch are kept until releaseRecordView
+    BM_PageHandle page;
+    RC result = pinTablePage(mgr, &page, id.page, false);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+    char *data = recordAt(mgr, page.data, id);
+    if (data == NULL)
+    {
+        releaseTablePage(mgr, &page, false);
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+    view->record.id = id;
+    view->record.data = data;
+    view->length = slotAt(page.data, id.slot)->length;
+    view->rel = rel;
+    view->page = page.data;
 
     return RC_OK;
 }
 
+RC releaseRecordView(RecordView *view)
+{
+    if (view == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    // Views of a scan are released by the scan itself
+    if (view->rel == NULL)
+    {
+        return RC_OK;
+    }
+
+    TableInfo *mgr = (TableInfo *)view->rel->mgmtData;
+    if (mgr == NULL)
+    {
+        return RC_ERROR;
+    }
+    BM_PageHandle page;
+    page.pageNum = view->record.id.page;
+    page.data = view->page;
+    view->rel = NULL;
+    view->page = NULL;
+    view->record.data = NULL;
+
+    return releaseTablePage(mgr, &page, false);
+}
+
+RC bulkLoadTable(char *name, Schema *schema, FILE *input, RM_BulkLoadOptions *options)
+{
+    RM_BulkLoadOptions defaults = {',', false, BULK_PAGES_PER_WRITE};
+
+    if (input == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+    if (options == NULL)
+    {
+        options = &defaults;
+    }
+
+    // createTable checks the schema and refuses a table that is open
+    RC result = createTable(name, schema);
+    if (result != RC_OK)
+    {
+        return result;
+    }
+
+    // The pages go straight to the file, bypassing the buffer pool; the
+    // table is not open, so no frame can hold a stale copy of them
+    BulkLoader *loader = (BulkLoader *)calloc(1, sizeof(BulkLoader));
+    if (loader != NULL)
+    {
+        loader->maxRunPages = (options->pagesPerWrite > 0) ? options->pagesPerWrite : BULK_PAGES_PER_WRITE;
+        loader->run = (char *)malloc((size_t)loader->maxRunPages * PAGE_SIZE);
+    }
+    if (loader == NULL || loader->run == NULL)
+    {
+        result = RC_MEMORY_ALLOCATION_ERROR;
+    }
+    else
+    {
+        result = openPageFile(name, &loader->fileHandle);
+    }
+    if (result == RC_OK)
+    {
+        loader->table.numPages = FIRST_GROUP_PAGE;
+        loader->table.firstFreePage = NO_PAGE;
+        loader->runStart = FIRST_GROUP_PAGE;
+        result = bulkLoadRecords(loader, schema, input, options);
+        RC closed = closePageFile(&loader->fileHandle);
+        if (result == RC_OK)
+        {
+            result = closed;
+        }
+    }
+    if (loader != NULL)
+    {
+        free(loader->run);
+        free(loader);
+    }
+
+    // A failed load leaves no table behind
+    if (result != RC_OK)
+    {
+        destroyPageFile(name);
+    }
+    return result;
+}
+
 RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
 {
-    printf("Starting scan\n");
     if (rel == NULL || scan == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -215,11 +1748,20 @@ RC startScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
         return RC_ERROR;
     }
 
+    // Every scan keeps its own position, so several can run at once
+    ScanInfo *scanInfo = (ScanInfo *)malloc(sizeof(ScanInfo));
+    if (scanInfo == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+    scanInfo->cond = cond;
+    scanInfo->page = FIRST_GROUP_PAGE + 1;
+    scanInfo->slot = 0;
+    scanInfo->viewPinned = false;
+
     scan->rel = rel;
-    scan->mgmtData = mgr;
-    mgr->scanIndex = 0;
+    scan->mgmtData = scanInfo;
 
-    printf("Scan started. Total tuples: %d\n", mgr->tupleCount);
     return RC_OK;
 }
 
@@ -230,42 +1772,116 @@ RC next(RM_ScanHandle *scan, Record *record)
         return RC_INVALID_PARAMETER;
     }
 
-    TableInfo *mgr = (TableInfo *)scan->mgmtData;
-    if (mgr == NULL)
+    ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+    TableInfo *mgr = (TableInfo *)scan->rel->mgmtData;
+    if (scanInfo == NULL || mgr == NULL)
     {
         return RC_ERROR;
     }
 
-    // Check if we have more records
-    if (mgr->scanIndex >= mgr->tupleCount)
+    // Walk the slots page by page, one pin per page visited
+    while (scanInfo->page < mgr->numPages)
     {
-        printf("No more tuples in scan\n");
-        return RC_RM_NO_MORE_TUPLES;
+        if (!isDataPage(scanInfo->page))
+        {
+            scanInfo->page++;
+            continue;
+        }
+        BM_PageHandle page;
+        RC result = pinTablePage(mgr, &page, scanInfo->page, false);
+        if (result != RC_OK)
+        {
+            return result;
+        }
+
+        // Only the matching record is copied out of the page
+        Record found;
+        result = scanPage(scan, page.data, &found);
+        if (result == RC_OK)
+        {
+            memcpy(record->data, found.data, slotAt(page.data, found.id.slot)->length);
+            record->id = found.id;
+        }
+        releaseTablePage(mgr, &page, false);
+        if (result != RC_RM_NO_MORE_TUPLES)
+        {
+            return result;
+        }
+        scanInfo->page++;
+        scanInfo->slot = 0;
     }
 
-    // Create a simple record
-    record->id.page = 1;
-    record->id.slot = mgr->scanIndex + 1;
-    mgr->scanIndex++;
+    return RC_RM_NO_MORE_TUPLES;
+}
 
-    printf("Scan returning record: page=%d, slot=%d (index=%d)\n", 
-           record->id.page, record->id.slot, mgr->scanIndex);
-    return RC_OK;
+RC nextView(RM_ScanHandle *scan, RecordView *view)
+{
+    if (scan == NULL || view == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+    TableInfo *mgr = (TableInfo *)scan->rel->mgmtData;
+    if (scanInfo == NULL || mgr == NULL)
+    {
+        return RC_ERROR;
+    }
+
+    // The page of the previous view stays pinned until the scan leaves it
+    while (scanInfo->page < mgr->numPages)
+    {
+        if (!isDataPage(scanInfo->page))
+        {
+            scanInfo->page++;
+            continue;
+        }
+        RC result;
+        if (!scanInfo->viewPinned)
+        {
+            result = pinTablePage(mgr, &scanInfo->viewPage, scanInfo->page, false);
+            if (result != RC_OK)
+            {
+                return result;
+            }
+            scanInfo->viewPinned = true;
+        }
+
+        result = scanPage(scan, scanInfo->viewPage.data, &view->record);
+        if (result == RC_OK)
+        {
+            view->length = slotAt(scanInfo->viewPage.data, view->record.id.slot)->length;
+            view->rel = NULL;
+            view->page = NULL;
+            return RC_OK;
+        }
+        releaseTablePage(mgr, &scanInfo->viewPage, false);
+        scanInfo->viewPinned = false;
+        if (result != RC_RM_NO_MORE_TUPLES)
+        {
+            return result;
+        }
+        scanInfo->page++;
+        scanInfo->slot = 0;
+    }
+
+    return RC_RM_NO_MORE_TUPLES;
 }
 
 RC closeScan(RM_ScanHandle *scan)
 {
-    printf("Closing scan\n");
     if (scan == NULL)
     {
         return RC_INVALID_PARAMETER;
     }
 
-    TableInfo *mgr = (TableInfo *)scan->mgmtData;
-    if (mgr != NULL)
+    ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+    if (scanInfo != NULL && scanInfo->viewPinned)
     {
-        mgr->scanIndex = 0;
+        releaseTablePage((TableInfo *)scan->rel->mgmtData, &scanInfo->viewPage, false);
     }
+    free(scanInfo);
+    scan->mgmtData = NULL;
 
     return RC_OK;
 }
@@ -277,33 +1893,36 @@ int getRecordSize(Schema *schema)
         return -1;
     }
 
-    int size = 1; // tombstone byte
+    // The largest size a record can take: a VARCHAR adds as many bytes as
+    // it can hold to the fixed-size part, a nullable attribute its value;
+    // on a page records take their actual length
+    int size = schema->fixedSize + 1; // tombstone byte
     for (int i = 0; i < schema->numAttr; i++)
     {
-        switch (schema->dataTypes[i])
+        if (attrSize(schema, i) < 0)
         {
-        case DT_STRING:
-            size += schema->typeLength[i];
-            break;
-        case DT_INT:
-            size += sizeof(int);
-            break;
-        case DT_FLOAT:
-            size += sizeof(float);
-            break;
-        case DT_BOOL:
-            size += sizeof(bool);
-            break;
-        default:
             return -1;
         }
+        if (schema->dataTypes[i] == DT_VARCHAR)
+        {
+            size += schema->typeLength[i];
+        }
+        else if (!storedInline(schema, i))
+        {
+            size += detachedSize(schema, i);
+        }
     }
-    return size;
+    return schema->aligned ? alignUp(size, RECORD_ALIGNMENT) : size;
 }
 
 Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys)
 {
-    printf("Creating schema with %d attributes\n", numAttr);
+    return createNullableSchema(numAttr, attrNames, dataTypes, typeLength, NULL, keySize, keys);
+}
+
+Schema *createNullableSchema(int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, bool *nullable,
+                             int keySize, int *keys)
+{
     if (numAttr <= 0 || attrNames == NULL || dataTypes == NULL)
     {
         return NULL;
@@ -319,6 +1938,8 @@ Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *ty
     char **newAttrNames = (char **)malloc(numAttr * sizeof(char *));
     DataType *newDataTypes = (DataType *)malloc(numAttr * sizeof(DataType));
     int *newTypeLength = (int *)malloc(numAttr * sizeof(int));
+    bool *newNullable = (bool *)malloc(numAttr * sizeof(bool));
+    int *newAttrOffsets = (int *)malloc(numAttr * sizeof(int));
     int *newKeyAttrs = NULL;
 
     if (keySize > 0)
@@ -326,11 +1947,14 @@ Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *ty
         newKeyAttrs = (int *)malloc(keySize * sizeof(int));
     }
 
-    if (newAttrNames == NULL || newDataTypes == NULL || newTypeLength == NULL || (keySize > 0 && newKeyAttrs == NULL))
+    if (newAttrNames == NULL || newDataTypes == NULL || newTypeLength == NULL || newNullable == NULL ||
+        newAttrOffsets == NULL || (keySize > 0 && newKeyAttrs == NULL))
     {
         free(newAttrNames);
         free(newDataTypes);
         free(newTypeLength);
+        free(newNullable);
+        free(newAttrOffsets);
         free(newKeyAttrs);
         free(schema);
         return NULL;
@@ -342,6 +1966,7 @@ Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *ty
         newAttrNames[i] = strdup(attrNames[i]);
         newDataTypes[i] = dataTypes[i];
         newTypeLength[i] = typeLength[i];
+        newNullable[i] = (nullable != NULL) ? nullable[i] : false; // no array, no nullable attributes
     }
 
     if (keySize > 0 && keys != NULL)
@@ -353,15 +1978,32 @@ Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes, int *ty
     schema->attrNames = newAttrNames;
     schema->dataTypes = newDataTypes;
     schema->typeLength = newTypeLength;
+    schema->nullable = newNullable;
+    schema->attrOffsets = newAttrOffsets;
+    schema->aligned = false;
     schema->keySize = keySize;
     schema->keyAttrs = newKeyAttrs;
+    computeLayout(schema);
 
     return schema;
 }
 
+RC alignSchema(Schema *schema)
+{
+    if (schema == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    // Changes the layout of the schema's records, so it has to happen
+    // before a table is created with it
+    schema->aligned = true;
+    computeLayout(schema);
+    return RC_OK;
+}
+
 RC freeSchema(Schema *schema)
 {
-    printf("Freeing schema\n");
     if (schema == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -386,6 +2028,14 @@ RC freeSchema(Schema *schema)
     {
         free(schema->typeLength);
     }
+    if (schema->nullable != NULL)
+    {
+        free(schema->nullable);
+    }
+    if (schema->attrOffsets != NULL)
+    {
+        free(schema->attrOffsets);
+    }
     if (schema->keyAttrs != NULL)
     {
         free(schema->keyAttrs);
@@ -397,7 +2047,6 @@ RC freeSchema(Schema *schema)
 
 RC createRecord(Record **record, Schema *schema)
 {
-    printf("Creating record\n");
     if (record == NULL || schema == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -423,8 +2072,15 @@ RC createRecord(Record **record, Schema *schema)
         return RC_MEMORY_ALLOCATION_ERROR;
     }
 
-    // Initialize with zeros
+    // Initialize with zeros, nullable attributes with NULL
     memset(newRecord->data, 0, recordSize);
+    for (int i = 0; i < schema->numAttr; i++)
+    {
+        if (schema->nullable[i])
+        {
+            setNullBit(newRecord->data, i, true);
+        }
+    }
     newRecord->id.page = -1;
     newRecord->id.slot = -1;
 
@@ -434,7 +2090,6 @@ RC createRecord(Record **record, Schema *schema)
 
 RC freeRecord(Record *record)
 {
-    printf("Freeing record\n");
     if (record == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -450,7 +2105,6 @@ RC freeRecord(Record *record)
 
 RC getAttr(Record *record, Schema *schema, int attrNum, Value **value)
 {
-    printf("Getting attribute %d\n", attrNum);
     if (record == NULL || schema == NULL || value == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -467,25 +2121,55 @@ RC getAttr(Record *record, Schema *schema, int attrNum, Value **value)
         return RC_MEMORY_ALLOCATION_ERROR;
     }
 
-    // Return appropriate default values based on data type
+    if (attrIsNull(schema, record->data, attrNum))
+    {
+        attrValue->dt = DT_NULL;
+        *value = attrValue;
+        return RC_OK;
+    }
+
+    // Decode the attribute from its position in the record
+    char *attrData = record->data + valueOffset(schema, record->data, attrNum);
     switch (schema->dataTypes[attrNum])
     {
     case DT_INT:
         attrValue->dt = DT_INT;
-        attrValue->v.intV = 0;
+        memcpy(&attrValue->v.intV, attrData, sizeof(int));
         break;
     case DT_FLOAT:
         attrValue->dt = DT_FLOAT;
-        attrValue->v.floatV = 0.0;
+        memcpy(&attrValue->v.floatV, attrData, sizeof(float));
         break;
     case DT_BOOL:
         attrValue->dt = DT_BOOL;
-        attrValue->v.boolV = false;
+        memcpy(&attrValue->v.boolV, attrData, sizeof(bool));
         break;
     case DT_STRING:
         attrValue->dt = DT_STRING;
-        attrValue->v.stringV = strdup("default");
+        attrValue->v.stringV = (char *)malloc(schema->typeLength[attrNum] + 1);
+        if (attrValue->v.stringV == NULL)
+        {
+            free(attrValue);
+            return RC_MEMORY_ALLOCATION_ERROR;
+        }
+        memcpy(attrValue->v.stringV, attrData, schema->typeLength[attrNum]);
+        attrValue->v.stringV[schema->typeLength[attrNum]] = '\0';
+        break;
+    case DT_VARCHAR:
+    {
+        VarcharRef ref;
+        memcpy(&ref, attrData, sizeof(VarcharRef));
+        attrValue->dt = DT_STRING;
+        attrValue->v.stringV = (char *)malloc(ref.length + 1);
+        if (attrValue->v.stringV == NULL)
+        {
+            free(attrValue);
+            return RC_MEMORY_ALLOCATION_ERROR;
+        }
+        memcpy(attrValue->v.stringV, record->data + ref.offset, ref.length);
+        attrValue->v.stringV[ref.length] = '\0';
         break;
+    }
     default:
         free(attrValue);
         return RC_ERROR;
@@ -497,7 +2181,6 @@ RC getAttr(Record *record, Schema *schema, int attrNum, Value **value)
 
 RC setAttr(Record *record, Schema *schema, int attrNum, Value *value)
 {
-    printf("Setting attribute %d\n", attrNum);
     if (record == NULL || schema == NULL || value == NULL)
     {
         return RC_INVALID_PARAMETER;
@@ -507,8 +2190,44 @@ RC setAttr(Record *record, Schema *schema, int attrNum, Value *value)
     {
         return RC_RM_NO_MORE_TUPLES;
     }
+    if (value->dt == DT_NULL)
+    {
+        if (!schema->nullable[attrNum])
+        {
+            return RC_RM_ATTR_NOT_NULLABLE;
+        }
+        setAttrNull(schema, record->data, attrNum);
+        return RC_OK;
+    }
+    DataType type = (schema->dataTypes[attrNum] == DT_VARCHAR) ? DT_STRING : schema->dataTypes[attrNum];
+    if (value->dt != type)
+    {
+        return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+    }
+    clearAttrNull(schema, record->data, attrNum);
 
-    // For this simple implementation, we just return success
-    // In a real implementation, we would serialize the value into record->data
+    // Encode the value at the attribute's position, strings are padded
+    // with zeros to their fixed length and VARCHARs take their own
+    char *attrData = record->data + valueOffset(schema, record->data, attrNum);
+    switch (schema->dataTypes[attrNum])
+    {
+    case DT_INT:
+        memcpy(attrData, &value->v.intV, sizeof(int));
+        break;
+    case DT_FLOAT:
+        memcpy(attrData, &value->v.floatV, sizeof(float));
+        break;
+    case DT_BOOL:
+        memcpy(attrData, &value->v.boolV, sizeof(bool));
+        break;
+    case DT_STRING:
+        strncpy(attrData, value->v.stringV, schema->typeLength[attrNum]);
+        break;
+    case DT_VARCHAR:
+        setVarchar(schema, record->data, attrNum, value->v.stringV);
+        break;
+    default:
+        return RC_ERROR;
+    }
     return RC_OK;
 }
@@ -1,6 +1,7 @@
 #ifndef RECORD_MGR_H
 #define RECORD_MGR_H
 
+#include <stdio.h>
 #include "dberror.h"
 #include "expr.h"
 #include "tables.h"
@@ -12,6 +13,27 @@ typedef struct RM_ScanHandle
   void *mgmtData;
 } RM_ScanHandle;
 
+// A record read in place by getRecordView or nextView. record.data points
+// into the frame of the record's page, which stays pinned and share-latched
+// while the view is held, so the holder must not change the table until it
+// lets go: with releaseRecordView for getRecordView, or with the next
+// nextView call or closeScan for a scan.
+typedef struct RecordView
+{
+  Record record;     // RID and the bytes of the record in the frame
+  int length;        // bytes of the record on its page
+  RM_TableData *rel; // table of a getRecordView, NULL for scan views
+  char *page;        // frame of the page, for releaseRecordView
+} RecordView;
+
+// Options of bulkLoadTable, NULL selects the defaults
+typedef struct RM_BulkLoadOptions
+{
+  char delimiter;    // field separator, ',' by default
+  bool skipHeader;   // the first line names the columns
+  int pagesPerWrite; // pages formatted in memory before each write
+} RM_BulkLoadOptions;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
@@ -23,18 +45,25 @@ extern int getNumTuples (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int n);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC bulkLoadTable (char *name, Schema *schema, FILE *input, RM_BulkLoadOptions *options);
+extern RC getRecordView (RM_TableData *rel, RID id, RecordView *view);
+extern RC releaseRecordView (RecordView *view);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
 extern RC next (RM_ScanHandle *scan, Record *record);
+extern RC nextView (RM_ScanHandle *scan, RecordView *view);
 extern RC closeScan (RM_ScanHandle *scan);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
 extern Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
+extern Schema *createNullableSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, bool *nullable, int keySize, int *keys);
+extern RC alignSchema (Schema *schema);
 extern RC freeSchema (Schema *schema);
 
 // dealing with records and attribute values
@@ -67,9 +67,6 @@ typedef struct VarString {
     free(tmp);					\
   } while(0)
 
-// prototypes
-static RC attrOffset (Schema *schema, int attrNum, int *result);
-
 // implementations
 char *
 serializeTableInfo(RM_TableData *rel)
@@ -131,10 +128,17 @@ serializeSchema(Schema *schema)
 	case DT_STRING:
 	  APPEND(result,"STRING[%i]", schema->typeLength[i]);
 	  break;
+	case DT_VARCHAR:
+	  APPEND(result,"VARCHAR[%i]", schema->typeLength[i]);
+	  break;
 	case DT_BOOL:
 	  APPEND_STRING(result,"BOOL");
 	  break;
+	default:
+	  break;
 	}
+      if (schema->nullable[i])
+	APPEND_STRING(result," NULL");
     }
   APPEND_STRING(result,")");
 
@@ -171,52 +175,34 @@ serializeRecord(Record *record, Schema *schema)
 char * 
 serializeAttr(Record *record, Schema *schema, int attrNum)
 {
-  int offset;
-  char *attrData;
+  Value *val;
   VarString *result;
+
+  // getAttr knows where the attribute is and whether it is NULL
+  if (getAttr(record, schema, attrNum, &val) != RC_OK)
+    return "NO SERIALIZER FOR DATATYPE";
   MAKE_VARSTRING(result);
-  
-  attrOffset(schema, attrNum, &offset);
-  attrData = record->data + offset;
 
-  switch(schema->dataTypes[attrNum])
+  switch(val->dt)
     {
     case DT_INT:
-      {
-	int val = 0;
-	memcpy(&val,attrData, sizeof(int));
-	APPEND(result, "%s:%i", schema->attrNames[attrNum], val);
-      }
+      APPEND(result, "%s:%i", schema->attrNames[attrNum], val->v.intV);
       break;
     case DT_STRING:
-      {
-	char *buf;
-	int len = schema->typeLength[attrNum];
-	buf = (char *) malloc(len + 1);
-	strncpy(buf, attrData, len);
-	buf[len] = '\0';
-	
-	APPEND(result, "%s:%s", schema->attrNames[attrNum], buf);
-	free(buf);
-      }
+      APPEND(result, "%s:%s", schema->attrNames[attrNum], val->v.stringV);
+      free(val->v.stringV);
       break;
     case DT_FLOAT:
-      {
-	float val;
-	memcpy(&val,attrData, sizeof(float));
-	APPEND(result, "%s:%f", schema->attrNames[attrNum], val);
-      }
+      APPEND(result, "%s:%f", schema->attrNames[attrNum], val->v.floatV);
       break;
     case DT_BOOL:
-      {
-	bool val;
-	memcpy(&val,attrData, sizeof(bool));
-	APPEND(result, "%s:%s", schema->attrNames[attrNum], val ? "TRUE" : "FALSE");
-      }
+      APPEND(result, "%s:%s", schema->attrNames[attrNum], val->v.boolV ? "TRUE" : "FALSE");
       break;
     default:
-      return "NO SERIALIZER FOR DATATYPE";
+      APPEND(result, "%s:NULL", schema->attrNames[attrNum]);
+      break;
     }
+  free(val);
 
   RETURN_STRING(result);
 }
@@ -241,6 +227,11 @@ serializeValue(Value *val)
     case DT_BOOL:
       APPEND_STRING(result, ((val->v.boolV) ? "true" : "false"));
       break;
+    case DT_NULL:
+      APPEND_STRING(result, "NULL");
+      break;
+    default:
+      break;
     }
 
   RETURN_STRING(result);
@@ -280,29 +271,3 @@ stringToValue(char *val)
 }
 
 
-RC 
-attrOffset (Schema *schema, int attrNum, int *result)
-{
-  int offset = 0;
-  int attrPos = 0;
-  
-  for(attrPos = 0; attrPos < attrNum; attrPos++)
-    switch (schema->dataTypes[attrPos])
-      {
-      case DT_STRING:
-	offset += schema->typeLength[attrPos];
-	break;
-      case DT_INT:
-	offset += sizeof(int);
-	break;
-      case DT_FLOAT:
-	offset += sizeof(float);
-	break;
-      case DT_BOOL:
-	offset += sizeof(bool);
-	break;
-      }
-  
-  *result = offset;
-  return RC_OK;
-}
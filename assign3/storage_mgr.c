@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <unistd.h>
 
 #include "storage_mgr.h"
 #include "dberror.h"
@@ -250,6 +253,107 @@ RC readBlock(int pageNum, SM_FileHandle *fh, SM_PageHandle memPage)
     return RC_OK;
 }
 
+/**
+ * Reads a run of consecutive pages with a single request.
+ *
+ * @param startPage First page number to read
+ * @param numPages Number of pages to read
+ * @param fh File handle
+ * @param memPages Buffer of numPages * PAGE_SIZE bytes for the pages
+ * @return RC_OK if successful, error code otherwise
+ *
+ * Seeks once and reads all pages in one call, so a long run costs one large
+ * sequential read instead of one request per page. Every page of the run
+ * must exist. The current page position is left on the last page read.
+ */
+RC readBlocks(int startPage, int numPages, SM_FileHandle *fh, SM_PageHandle memPages)
+{
+    // Validate the first and the last page of the run
+    RC valid = validate_read(fh, startPage, memPages);
+    if (valid != RC_OK)
+        return valid;
+    if (numPages <= 0 || startPage + numPages > fh->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    FILE *fp = (FILE *)fh->mgmtInfo;
+    if (fseek(fp, (long)startPage * PAGE_SIZE, SEEK_SET))
+        return RC_READ_NON_EXISTING_PAGE;
+
+    // Read the whole run at once
+    if (fread(memPages, PAGE_SIZE, numPages, fp) != (size_t)numPages)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    fh->curPagePos = startPage + numPages - 1;
+    return RC_OK;
+}
+
+/**
+ * Reads a run of consecutive pages into separate page buffers.
+ *
+ * @param startPage First page number to read
+ * @param numPages Number of pages to read
+ * @param fh File handle
+ * @param memPages One buffer of PAGE_SIZE bytes per page
+ * @return RC_OK if successful, error code otherwise
+ *
+ * Like readBlocks, but scatters the run into buffers that need not be
+ * adjacent, such as the frames of a buffer pool, with one vectored read.
+ * Pending writes of the file's stream are flushed first, since the read
+ * goes to the descriptor directly. Every page of the run must exist.
+ */
+RC readBlocksVectored(int startPage, int numPages, SM_FileHandle *fh, SM_PageHandle *memPages)
+{
+    int i;
+
+    // Validate the run and its buffers
+    if (!fh)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (!memPages || numPages <= 0)
+        return RC_WRITE_FAILED;
+    if (startPage < 0 || startPage + numPages > fh->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    FILE *fp = (FILE *)fh->mgmtInfo;
+    if (fflush(fp))
+        return RC_READ_NON_EXISTING_PAGE;
+
+    struct iovec *iov = malloc(sizeof(struct iovec) * numPages);
+    if (!iov)
+        return RC_WRITE_FAILED;
+    for (i = 0; i < numPages; i++)
+    {
+        iov[i].iov_base = memPages[i];
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    // Continue after short reads until the whole run is in
+    off_t offset = (off_t)startPage * PAGE_SIZE;
+    int first = 0;
+    RC rc = RC_OK;
+    while (first < numPages)
+    {
+        ssize_t n = preadv(fileno(fp), iov + first, numPages - first > IOV_MAX ? IOV_MAX : numPages - first, offset);
+        if (n <= 0)
+        {
+            rc = RC_READ_NON_EXISTING_PAGE;
+            break;
+        }
+        offset += n;
+        while (first < numPages && n >= (ssize_t)iov[first].iov_len)
+            n -= iov[first++].iov_len;
+        if (first < numPages)
+        {
+            iov[first].iov_base = (char *)iov[first].iov_base + n;
+            iov[first].iov_len -= n;
+        }
+    }
+    free(iov);
+
+    if (rc == RC_OK)
+        fh->curPagePos = startPage + numPages - 1;
+    return rc;
+}
+
 /**
  * Author: Purnendu Kale
  * Returns the current page position in the file.
@@ -405,6 +509,42 @@ RC writeBlock(int pageNum, SM_FileHandle *fh, SM_PageHandle memPage)
     return RC_OK;
 }
 
+/**
+ * Writes a run of consecutive pages with a single request.
+ *
+ * @param startPage First page number to write
+ * @param numPages Number of pages to write
+ * @param fh File handle
+ * @param memPages Buffer of numPages * PAGE_SIZE bytes with the pages
+ * @return RC_OK if successful, error code otherwise
+ *
+ * The write counterpart of readBlocks: seeks once and writes all pages in
+ * one call. The run may start at the end of the file or extend past it, in
+ * which case the file grows by the pages written; it must not leave a gap.
+ * The current page position is left on the last page written.
+ */
+RC writeBlocks(int startPage, int numPages, SM_FileHandle *fh, SM_PageHandle memPages)
+{
+    // Validate input parameters
+    if (!fh || !memPages)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (numPages <= 0 || startPage < 0 || startPage > fh->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    FILE *fp = (FILE *)fh->mgmtInfo;
+    if (fseek(fp, (long)startPage * PAGE_SIZE, SEEK_SET))
+        return RC_WRITE_FAILED;
+
+    // Write the whole run at once
+    if (fwrite(memPages, PAGE_SIZE, numPages, fp) != (size_t)numPages)
+        return RC_WRITE_FAILED;
+
+    if (startPage + numPages > fh->totalNumPages)
+        fh->totalNumPages = startPage + numPages;
+    fh->curPagePos = startPage + numPages - 1;
+    return RC_OK;
+}
+
 /**
  * Author: Nijgururaj Ashtagi
  * Writes a page to disk at the current position.
@@ -8,9 +8,20 @@ typedef enum DataType {
   DT_INT = 0,
   DT_STRING = 1,
   DT_FLOAT = 2,
-  DT_BOOL = 3
+  DT_BOOL = 3,
+  DT_VARCHAR = 4, // string of up to typeLength bytes, stored at its length
+  DT_NULL = 5     // type of NULL values, not of attributes
 } DataType;
 
+// A VARCHAR attribute takes a VarcharRef in the fixed-size part of a
+// record: the offset of its bytes from the start of the record and their
+// number. The bytes of all VARCHARs are packed after the fixed-size part.
+// Values of VARCHAR attributes are DT_STRING values.
+typedef struct VarcharRef {
+  unsigned short offset;
+  unsigned short length;
+} VarcharRef;
+
 typedef struct Value {
   DataType dt;
   union v {
@@ -39,6 +50,12 @@ typedef struct Schema
   char **attrNames;
   DataType *dataTypes;
   int *typeLength;
+  bool *nullable; // attributes that may hold NULL
+  int *attrOffsets; // offset of each attribute in a record, -1 if nullable
+                    // with a fixed size, which is stored after fixedSize
+  int fixedSize;    // bytes of the fixed-size part of a record
+  bool varLength;   // records have VARCHARs or nullable attributes
+  bool aligned;     // attributes at offsets aligned to their size
   int *keyAttrs;
   int keySize;
 } Schema;
@@ -60,6 +77,15 @@ typedef struct RM_TableData
   } while(0)
 
 
+#define MAKE_NULL_VALUE(result)					\
+  do {									\
+    (result) = (Value *) malloc(sizeof(Value));				\
+    (result)->dt = DT_NULL;						\
+  } while(0)
+
+#define IS_NULL(value) ((value)->dt == DT_NULL)
+
+
 #define MAKE_VALUE(result, datatype, value)				\
   do {									\
     (result) = (Value *) malloc(sizeof(Value));				\
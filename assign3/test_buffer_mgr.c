@@ -0,0 +1,1435 @@
+#include <pthread.h>
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "test_helper.h"
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected, bm, message)      \
+  do                                                   \
+  {                                                    \
+    char *real;                                        \
+    char *_exp = (char *)(expected);                   \
+    real = sprintPoolContent(bm);                      \
+    if (strcmp((_exp), real) != 0)                     \
+    {                                                  \
+      printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n", TEST_INFO, _exp, real, message); \
+      free(real);                                      \
+      exit(1);                                         \
+    }                                                  \
+    printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n", TEST_INFO, _exp, real, message); \
+    free(real);                                        \
+  } while (0)
+
+#define TEST_FILE "testbuffer.bin"
+#define TEST_FILE2 "testbuffer2.bin"
+#define TRACE_FILE "testtrace.bin"
+#define QUOTED_FILE "test\"buf\\fer.bin"
+#define NUM_THREADS 8
+#define PINS_PER_THREAD 20000
+
+// pool of testCheckpoint, shared with its writer threads
+static BM_BufferPool *checkpointPool;
+
+// test methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+static void checkDummyPages(BM_BufferPool *bm, int num);
+static void testCreatingAndReadingDummyPages(void);
+static void testFIFO(void);
+static void testLRU(void);
+static void testConcurrentPins(void);
+static void testBackgroundWriter(void);
+static void testPrefetch(void);
+static void testSharedPool(void);
+static void testResize(void);
+static void testPoolStats(void);
+static void testPageTrace(void);
+static void testWarmStart(void);
+static void testPinPages(void);
+static void testPageLatches(void);
+static void testOptimisticReads(void);
+static void testEvictor(void);
+static void testPageHints(void);
+static void testCheckpoint(void);
+static void testHugePages(void);
+
+// test name
+char *testName;
+
+// main method
+int main(void)
+{
+  initStorageManager();
+  testName = "";
+
+  testCreatingAndReadingDummyPages();
+  testFIFO();
+  testLRU();
+  testConcurrentPins();
+  testBackgroundWriter();
+  testPrefetch();
+  testSharedPool();
+  testResize();
+  testPoolStats();
+  testPageTrace();
+  testWarmStart();
+  testPinPages();
+  testPageLatches();
+  testOptimisticReads();
+  testEvictor();
+  testPageHints();
+  testCheckpoint();
+  testHugePages();
+
+  return 0;
+}
+
+// create n pages with content "Page X" and read them back to check whether the content is right
+void testCreatingAndReadingDummyPages(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  testName = "Creating and Reading Back Dummy Pages";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+
+  createDummyPages(bm, 22);
+  checkDummyPages(bm, 20);
+
+  createDummyPages(bm, 10000);
+  checkDummyPages(bm, 10000);
+
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  TEST_DONE();
+}
+
+void createDummyPages(BM_BufferPool *bm, int num)
+{
+  int i;
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+
+  for (i = 0; i < num; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(h->data, "%s-%i", "Page", h->pageNum);
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  free(h);
+}
+
+void checkDummyPages(BM_BufferPool *bm, int num)
+{
+  int i;
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char *expected = malloc(sizeof(char) * 512);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+
+  for (i = 0; i < num; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+
+    sprintf(expected, "%s-%i", "Page", h->pageNum);
+    if (strcmp(expected, h->data) != 0)
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back dummy page content");
+
+    TEST_CHECK(unpinPage(bm, h));
+  }
+
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  free(expected);
+  free(h);
+}
+
+// test the FIFO page replacement strategy
+void testFIFO(void)
+{
+  // expected results
+  const char *poolContents[] = {
+      "[0 0],[-1 0],[-1 0]",
+      "[0 0],[1 0],[-1 0]",
+      "[0 0],[1 0],[2 0]",
+      "[3 0],[1 0],[2 0]",
+      "[3 0],[4 0],[2 0]",
+      "[3 0],[4 1],[2 0]",
+      "[3 0],[4 1],[5x0]",
+      "[6x0],[4 1],[5x0]",
+      "[6x0],[4 1],[0x0]",
+      "[6x0],[4 0],[0x0]",
+      "[6 0],[4 0],[0 0]"};
+  const int requests[] = {0, 1, 2, 3, 4, 4, 5, 6, 0};
+  const int numLinRequests = 5;
+  const int numChangeRequests = 3;
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing FIFO page replacement";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+
+  createDummyPages(bm, 100);
+
+  ASSERT_ERROR(initBufferPool(bm, TEST_FILE, 3, RS_LRU_K, NULL), "strategy without victim selection");
+  ASSERT_ERROR(initSharedBufferPool(bm, 3, RS_LRU_K, NULL), "shared pool with that strategy");
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+
+  // reading some pages linearly with direct unpin and no modifications
+  for (i = 0; i < numLinRequests; i++)
+  {
+    pinPage(bm, h, requests[i]);
+    unpinPage(bm, h);
+    ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  // pin one page and test remainder
+  i = numLinRequests;
+  pinPage(bm, h, requests[i]);
+  ASSERT_EQUALS_POOL(poolContents[i], bm, "pool content after pin page");
+
+  // read pages and mark them as dirty
+  for (i = numLinRequests + 1; i < numLinRequests + numChangeRequests + 1; i++)
+  {
+    pinPage(bm, h, requests[i]);
+    markDirty(bm, h);
+    unpinPage(bm, h);
+    ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  // flush buffer pool to disk
+  i = numLinRequests + numChangeRequests + 1;
+  h->pageNum = 4;
+  unpinPage(bm, h);
+  ASSERT_EQUALS_POOL(poolContents[i], bm, "unpin last page");
+
+  i++;
+  forceFlushPool(bm);
+  ASSERT_EQUALS_POOL(poolContents[i], bm, "pool content after flush");
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LRU page replacement strategy
+void testLRU(void)
+{
+  // expected results
+  const char *poolContents[] = {
+      // read first five pages and directly unpin them
+      "[0 0],[-1 0],[-1 0],[-1 0],[-1 0]",
+      "[0 0],[1 0],[-1 0],[-1 0],[-1 0]",
+      "[0 0],[1 0],[2 0],[-1 0],[-1 0]",
+      "[0 0],[1 0],[2 0],[3 0],[-1 0]",
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      // use some of the page to create a fixed LRU order without changing pool content
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      "[0 0],[1 0],[2 0],[3 0],[4 0]",
+      // check that pages get evicted in LRU order
+      "[0 0],[1 0],[2 0],[5 0],[4 0]",
+      "[0 0],[1 0],[2 0],[5 0],[6 0]",
+      "[7 0],[1 0],[2 0],[5 0],[6 0]",
+      "[7 0],[1 0],[8 0],[5 0],[6 0]",
+      "[7 0],[9 0],[8 0],[5 0],[6 0]"};
+  const int orderRequests[] = {3, 4, 0, 2, 1};
+  const int numLRUOrderChange = 5;
+
+  int i;
+  int snapshot = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LRU page replacement";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 100);
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 5, RS_LRU, NULL));
+
+  // reading first five pages linearly with direct unpin and no modifications
+  for (i = 0; i < 5; i++)
+  {
+    pinPage(bm, h, i);
+    unpinPage(bm, h);
+    ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content reading in pages");
+  }
+
+  // read pages to change LRU order
+  for (i = 0; i < numLRUOrderChange; i++)
+  {
+    pinPage(bm, h, orderRequests[i]);
+    unpinPage(bm, h);
+    ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+  }
+
+  // replace pages and check that it happens in LRU order
+  for (i = 0; i < 5; i++)
+  {
+    pinPage(bm, h, 5 + i);
+    unpinPage(bm, h);
+    ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+  }
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(10, getNumReadIO(bm), "check number of read I/Os");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// shared state of the concurrent pin test
+typedef struct PinWorker
+{
+  BM_BufferPool *bm;
+  unsigned int seed;
+  int errors;
+} PinWorker;
+
+static void *pinWorker(void *arg)
+{
+  PinWorker *worker = (PinWorker *)arg;
+  BM_PageHandle h;
+  char expected[64];
+  int i;
+
+  for (i = 0; i < PINS_PER_THREAD; i++)
+  {
+    // a small hot set makes concurrent misses on the same page likely
+    int pageNum = rand_r(&worker->seed) % ((i % 4 == 0) ? 200 : 12);
+
+    if (pinPage(worker->bm, &h, pageNum) != RC_OK)
+    {
+      worker->errors++;
+      continue;
+    }
+    sprintf(expected, "%s-%i", "Page", pageNum);
+    if (strcmp(expected, h.data) != 0)
+      worker->errors++;
+    if (pageNum % 7 == 0)
+      markDirty(worker->bm, &h);
+    if (unpinPage(worker->bm, &h) != RC_OK)
+      worker->errors++;
+  }
+  return NULL;
+}
+
+// pin and unpin pages from several threads and check that every pin sees
+// the right page and no pin is lost
+void testConcurrentPins(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  pthread_t threads[NUM_THREADS];
+  PinWorker workers[NUM_THREADS];
+  ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU};
+  int s, i, errors;
+  testName = "Testing concurrent pin and unpin";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 200);
+
+  for (s = 0; s < 4; s++)
+  {
+    TEST_CHECK(initBufferPool(bm, TEST_FILE, 16, strategies[s], NULL));
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+      workers[i].bm = bm;
+      workers[i].seed = i + 1;
+      workers[i].errors = 0;
+      pthread_create(&threads[i], NULL, pinWorker, &workers[i]);
+    }
+    errors = 0;
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+      pthread_join(threads[i], NULL);
+      errors += workers[i].errors;
+    }
+    ASSERT_EQUALS_INT(0, errors, "every pin returned the right page");
+
+    int *fixCounts = getFixCounts(bm);
+    for (i = 0; i < bm->numPages; i++)
+      errors += fixCounts[i];
+    free(fixCounts);
+    ASSERT_EQUALS_INT(0, errors, "no pin left behind");
+
+    TEST_CHECK(shutdownBufferPool(bm));
+  }
+
+  checkDummyPages(bm, 200);
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  TEST_DONE();
+}
+
+// dirty pages are cleaned by the background writer, so later misses do not
+// have to write their victims
+void testBackgroundWriter(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int i, wait;
+  testName = "Testing the background writer";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 5, RS_LRU, NULL));
+  TEST_CHECK(startBackgroundWriter(bm, 1, 2));
+  ASSERT_ERROR(startBackgroundWriter(bm, 1, 2), "only one writer per pool");
+
+  // dirty every frame of the pool
+  for (i = 0; i < 5; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(h->data, "%s-%i", "Page", 100 + i);
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+
+  // wait until the writer has cleaned all of them
+  for (wait = 0; wait < 5000 && getNumBackgroundWriteIO(bm) < 5; wait++)
+  {
+    struct timespec ms = {0, 1000000};
+    nanosleep(&ms, NULL);
+  }
+  ASSERT_EQUALS_INT(5, getNumBackgroundWriteIO(bm), "writer cleaned the dirty pages");
+
+  // misses now find clean victims
+  for (i = 5; i < 10; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(0, getNumForegroundWriteIO(bm), "no victim written on the miss path");
+
+  TEST_CHECK(stopBackgroundWriter(bm));
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  // the cleaned pages reached the disk
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 5, RS_LRU, NULL));
+  TEST_CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_STRING("Page-103", h->data, "page written by the background writer");
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// prefetched pages are loaded unpinned, so the following pins are hits
+void testPrefetch(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char expected[64];
+  int i, wait;
+  testName = "Testing page prefetch";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 8, RS_LRU, NULL));
+  TEST_CHECK(prefetchPages(bm, 4, 6));
+  TEST_CHECK(prefetchPage(bm, 4));
+
+  // wait until the prefetch thread has read the pages
+  for (wait = 0; wait < 5000 && getNumReadIO(bm) < 6; wait++)
+  {
+    struct timespec ms = {0, 1000000};
+    nanosleep(&ms, NULL);
+  }
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "each page read once");
+  ASSERT_EQUALS_POOL("[4 0],[5 0],[6 0],[7 0],[8 0],[9 0],[-1 0],[-1 0]", bm, "prefetched pages are unpinned");
+
+  for (i = 4; i < 10; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "prefetched page content");
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "pins after the prefetch are hits");
+
+  // a pin racing with the prefetch of the same page shares its read
+  TEST_CHECK(prefetchPage(bm, 12));
+  TEST_CHECK(pinPage(bm, h, 12));
+  ASSERT_EQUALS_STRING("Page-12", h->data, "pin during prefetch");
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "page read once");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// two files attached to one shared pool compete for the same frames
+void testSharedPool(void)
+{
+  BM_BufferPool *pool = MAKE_POOL();
+  BM_BufferPool *a = MAKE_POOL();
+  BM_BufferPool *b = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int i;
+  testName = "Testing a buffer pool shared by two files";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  TEST_CHECK(createPageFile(TEST_FILE2));
+
+  TEST_CHECK(initSharedBufferPool(pool, 4, RS_LRU, NULL));
+  TEST_CHECK(attachBufferPool(a, pool, TEST_FILE));
+  TEST_CHECK(attachBufferPool(b, pool, TEST_FILE2));
+  ASSERT_TRUE(pinPage(pool, h, 0) == RC_FILE_HANDLE_NOT_INIT, "the bare pool has no file");
+
+  // page 0 of both files is cached separately
+  TEST_CHECK(pinPage(a, h, 0));
+  sprintf(h->data, "%s", "A-0");
+  TEST_CHECK(markDirty(a, h));
+  TEST_CHECK(unpinPage(a, h));
+  TEST_CHECK(pinPage(b, h, 0));
+  sprintf(h->data, "%s", "B-0");
+  TEST_CHECK(markDirty(b, h));
+  TEST_CHECK(unpinPage(b, h));
+  ASSERT_EQUALS_POOL("[0x0],[-1 0],[-1 0],[-1 0]", a, "first file sees only its page");
+  ASSERT_EQUALS_POOL("[-1 0],[0x0],[-1 0],[-1 0]", b, "second file sees only its page");
+  ASSERT_EQUALS_POOL("[0x0],[0x0],[-1 0],[-1 0]", pool, "pool sees both pages");
+
+  // the busy file takes the frames of the idle one
+  for (i = 1; i < 5; i++)
+  {
+    TEST_CHECK(pinPage(a, h, i));
+    TEST_CHECK(unpinPage(a, h));
+  }
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[1 0],[2 0]", a, "first file fills the pool");
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0],[-1 0]", b, "second file was evicted");
+  ASSERT_EQUALS_INT(5, getNumReadIO(a), "reads of the first file");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(a), "writes of the first file");
+  ASSERT_EQUALS_INT(1, getNumReadIO(b), "reads of the second file");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(b), "writes of the second file");
+  ASSERT_EQUALS_INT(6, getNumReadIO(pool), "reads of the pool");
+
+  // detaching leaves the other file cached, reattaching rereads from disk
+  ASSERT_TRUE(shutdownBufferPool(pool) == RC_BUFFER_POOL_IN_USE, "pool still in use");
+  TEST_CHECK(shutdownBufferPool(b));
+  TEST_CHECK(attachBufferPool(b, pool, TEST_FILE2));
+  TEST_CHECK(pinPage(b, h, 0));
+  ASSERT_EQUALS_STRING("B-0", h->data, "page written back on eviction");
+  ASSERT_TRUE(shutdownBufferPool(b) == RC_PINNED_PAGES_IN_BUFFER, "cannot detach with a pinned page");
+  TEST_CHECK(unpinPage(b, h));
+  TEST_CHECK(shutdownBufferPool(b));
+
+  TEST_CHECK(pinPage(a, h, 0));
+  ASSERT_EQUALS_STRING("A-0", h->data, "page written back on eviction");
+  TEST_CHECK(unpinPage(a, h));
+  TEST_CHECK(shutdownBufferPool(a));
+  TEST_CHECK(shutdownBufferPool(pool));
+
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+  TEST_CHECK(destroyPageFile(TEST_FILE2));
+
+  free(pool);
+  free(a);
+  free(b);
+  free(h);
+  TEST_DONE();
+}
+
+// grow and shrink a pool while pages are pinned
+void testResize(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  char expected[64];
+  int i, round;
+  testName = "Testing online resize of a buffer pool";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 4, RS_LRU, NULL));
+  for (i = 0; i < 4; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(pinPage(bm, h, 1));
+
+  // shrinking evicts the least recently used unpinned pages
+  TEST_CHECK(resizeBufferPool(bm, 2));
+  ASSERT_EQUALS_INT(2, bm->numPages, "pool shrunk");
+  ASSERT_EQUALS_POOL("[1 1],[3 0]", bm, "pinned page stays");
+
+  TEST_CHECK(pinPage(bm, h2, 3));
+  ASSERT_TRUE(resizeBufferPool(bm, 1) == RC_PINNED_PAGES_IN_BUFFER, "cannot evict pinned pages");
+  ASSERT_EQUALS_INT(2, bm->numPages, "size unchanged");
+  TEST_CHECK(unpinPage(bm, h2));
+  TEST_CHECK(resizeBufferPool(bm, 1));
+  ASSERT_EQUALS_POOL("[1 1]", bm, "one frame left");
+
+  // growing reuses the retired frames before adding new ones
+  TEST_CHECK(resizeBufferPool(bm, 5));
+  ASSERT_EQUALS_POOL("[-1 0],[1 1],[-1 0],[-1 0],[-1 0]", bm, "pool grown");
+  for (i = 10; i < 14; i++)
+  {
+    TEST_CHECK(pinPage(bm, h2, i));
+    TEST_CHECK(unpinPage(bm, h2));
+  }
+  ASSERT_EQUALS_POOL("[11 0],[1 1],[12 0],[13 0],[10 0]", bm, "new frames are used");
+  ASSERT_EQUALS_INT(8, getNumReadIO(bm), "reads so far");
+
+  // grow past one extent, every page fits afterwards
+  TEST_CHECK(resizeBufferPool(bm, 300));
+  for (round = 0; round < 2; round++)
+    for (i = 0; i < 20; i++)
+    {
+      TEST_CHECK(pinPage(bm, h2, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h2->data, "reading back dummy page content");
+      TEST_CHECK(unpinPage(bm, h2));
+    }
+  ASSERT_EQUALS_INT(23, getNumReadIO(bm), "second round only hits");
+
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  free(h2);
+  TEST_DONE();
+}
+
+// hits, misses, evictions and the machine readable dump
+void testPoolStats(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  long reads = 0, writes = 0;
+  char *dump;
+  int i;
+  testName = "Testing buffer pool statistics";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 10);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+  TEST_CHECK(pinPage(bm, h, 0));
+  TEST_CHECK(markDirty(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  for (i = 1; i < 5; i++)
+  {
+    if (i == 3)
+    {
+      // hit on page 0 before it is replaced
+      TEST_CHECK(pinPage(bm, h, 0));
+      TEST_CHECK(unpinPage(bm, h));
+    }
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(pinPage(bm, h, 4));
+  TEST_CHECK(forcePage(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(3, stats.numPages, "pool size");
+  ASSERT_EQUALS_INT(2, (int)stats.hits, "hits");
+  ASSERT_EQUALS_INT(5, (int)stats.misses, "misses");
+  ASSERT_EQUALS_INT(1, (int)stats.cleanEvictions, "clean evictions");
+  ASSERT_EQUALS_INT(1, (int)stats.dirtyEvictions, "dirty evictions");
+  ASSERT_EQUALS_INT(1, (int)stats.forcedWrites, "forced writes");
+  ASSERT_EQUALS_INT(getNumReadIO(bm), (int)stats.reads, "reads");
+  ASSERT_EQUALS_INT(getNumWriteIO(bm), (int)stats.writes, "writes");
+  for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+  {
+    reads += stats.readLatency[i];
+    writes += stats.writeLatency[i];
+  }
+  ASSERT_EQUALS_INT(5, (int)reads, "every read is in the histogram");
+  ASSERT_EQUALS_INT(2, (int)writes, "every write is in the histogram");
+
+  dump = sprintPoolStats(bm, BM_STATS_JSON);
+  ASSERT_TRUE(strstr(dump, "\"hits\": 2, \"misses\": 5, \"hitRatio\": 0.2857") != NULL, "json dump");
+  free(dump);
+  dump = sprintPoolStats(bm, BM_STATS_CSV);
+  ASSERT_TRUE(strncmp(dump, "page_file,strategy,num_pages,hits,misses", 40) == 0, "csv header");
+  ASSERT_TRUE(strstr(dump, "\ntestbuffer.bin,FIFO,3,2,5,0.2857,1,1,1,0,0,5,2,") != NULL, "csv row");
+  free(dump);
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+  ASSERT_ERROR(getPoolStats(bm, &stats), "pool is shut down");
+  ASSERT_TRUE(sprintPoolStats(bm, BM_STATS_JSON) == NULL, "no dump of a closed pool");
+
+  // the file name is escaped in the JSON dump
+  TEST_CHECK(createPageFile(QUOTED_FILE));
+  TEST_CHECK(initBufferPool(bm, QUOTED_FILE, 3, RS_FIFO, NULL));
+  dump = sprintPoolStats(bm, BM_STATS_JSON);
+  ASSERT_TRUE(strncmp(dump, "{\"pageFile\": \"test\\\"buf\\\\fer.bin\", ", 35) == 0, "escaped file name");
+  free(dump);
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(QUOTED_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// access trace of a pool without page file
+void testPageTrace(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_TraceRecord records[8];
+  char magic[BM_TRACE_MAGIC_LEN];
+  FILE *trace;
+  int i;
+  testName = "Testing page access trace";
+
+  // no page file: pages start zeroed and evicted pages are dropped
+  TEST_CHECK(initBufferPool(bm, NULL, 2, RS_LRU, NULL));
+  TEST_CHECK(pinPage(bm, h, 7));
+  ASSERT_EQUALS_INT(0, h->data[0], "new page is zeroed");
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(startPageTrace(bm, TRACE_FILE));
+  ASSERT_ERROR(startPageTrace(bm, TRACE_FILE), "only one trace at a time");
+  TEST_CHECK(pinPage(bm, h, 3));
+  TEST_CHECK(markDirty(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(pinPage(bm, h, 7));
+  ASSERT_ERROR(pinPage(bm, h, -1), "failed pins are not traced");
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(stopPageTrace(bm));
+  TEST_CHECK(pinPage(bm, h, 4));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[7 0],[4 0]", bm, "dirty page is evicted without a page file");
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "misses are counted as reads");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "dirty evictions are counted as writes");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  trace = fopen(TRACE_FILE, "rb");
+  ASSERT_TRUE(trace != NULL, "trace file written");
+  i = (int)fread(magic, 1, BM_TRACE_MAGIC_LEN, trace);
+  ASSERT_TRUE(i == BM_TRACE_MAGIC_LEN && memcmp(magic, BM_TRACE_MAGIC, i) == 0, "trace header");
+  i = (int)fread(records, sizeof(BM_TraceRecord), 8, trace);
+  ASSERT_EQUALS_INT(5, i, "one record per access");
+  fclose(trace);
+  ASSERT_TRUE(records[0].op == BM_TRACE_PIN && records[0].pageNum == 3, "pin 3");
+  ASSERT_TRUE(records[1].op == BM_TRACE_DIRTY && records[1].pageNum == 3, "dirty 3");
+  ASSERT_TRUE(records[2].op == BM_TRACE_UNPIN && records[2].pageNum == 3, "unpin 3");
+  ASSERT_TRUE(records[3].op == BM_TRACE_PIN && records[3].pageNum == 7, "pin 7");
+  ASSERT_TRUE(records[4].op == BM_TRACE_UNPIN && records[4].pageNum == 7, "unpin 7");
+  for (i = 1; i < 5; i++)
+    ASSERT_TRUE(records[i].timestamp >= records[i - 1].timestamp, "records in time order");
+  remove(TRACE_FILE);
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// dump the resident pages on shutdown and load them on the next start
+void testWarmStart(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions dump = {true, false, NULL};
+  BM_PoolOptions load = {false, true, NULL};
+  BM_PoolOptions missing = {false, true, "nonexistent.warm"};
+  const PageNumber pages[] = {10, 3, 11, 12, 4, 11};
+  int i;
+  testName = "Testing buffer pool warm-up";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+
+  // leaves 3, 12, 4 and 11 resident, 11 used last
+  TEST_CHECK(initBufferPoolWithOptions(bm, TEST_FILE, 4, RS_LRU, NULL, &dump));
+  for (i = 0; i < 6; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, pages[i]));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  // a smaller pool takes the three most recent pages in page order
+  TEST_CHECK(initBufferPoolWithOptions(bm, TEST_FILE, 3, RS_LRU, NULL, &load));
+  ASSERT_EQUALS_POOL("[4 0],[11 0],[12 0]", bm, "warm pages loaded in page order");
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "one read per loaded page");
+  TEST_CHECK(pinPage(bm, h, 11));
+  ASSERT_EQUALS_STRING("Page-11", h->data, "loaded page content");
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "loaded page is a hit");
+
+  // the recency of the last run is restored, so 12 is evicted before 4
+  TEST_CHECK(pinPage(bm, h, 5));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[4 0],[11 0],[5 0]", bm, "least recently used page before the restart evicted");
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  // no warm-up file: the pool simply starts cold
+  TEST_CHECK(initBufferPoolWithOptions(bm, TEST_FILE, 3, RS_LRU, NULL, &missing));
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0]", bm, "cold start");
+  ASSERT_ERROR(loadBufferPool(bm, "nonexistent.warm"), "loading a missing warm-up file");
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  remove(TEST_FILE BM_WARM_SUFFIX);
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// batched pins and unpins
+void testPinPages(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle pages[6];
+  const PageNumber batch[] = {5, 2, 6, 7, 5, 9};
+  const PageNumber tooMany[] = {10, 11, 12, 13, 14, 15};
+  const PageNumber pastEnd[] = {26, 25};
+  int *fixCounts;
+  int i, pinned;
+  testName = "Testing batched pin and unpin";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 6, RS_LRU, NULL));
+  TEST_CHECK(pinPage(bm, h, 2));
+
+  // misses are loaded in page order, repeated pages pinned twice
+  TEST_CHECK(pinPages(bm, pages, batch, 6));
+  ASSERT_EQUALS_POOL("[2 2],[5 2],[6 1],[7 1],[9 1],[-1 0]", bm, "batch pinned");
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "each missed page read once");
+  for (i = 0; i < 6; i++)
+  {
+    char expected[16];
+    sprintf(expected, "Page-%i", batch[i]);
+    ASSERT_EQUALS_INT(batch[i], pages[i].pageNum, "handle in request order");
+    ASSERT_EQUALS_STRING(expected, pages[i].data, "page content");
+  }
+  TEST_CHECK(unpinPages(bm, pages, 6));
+  ASSERT_EQUALS_POOL("[2 1],[5 0],[6 0],[7 0],[9 0],[-1 0]", bm, "batch unpinned");
+  ASSERT_ERROR(unpinPages(bm, pages, 1), "unpinning a page that is not pinned");
+
+  // more pages than unpinned frames: nothing of the request stays pinned
+  ASSERT_ERROR(pinPages(bm, pages, tooMany, 6), "batch larger than the free frames");
+  fixCounts = getFixCounts(bm);
+  for (i = 0, pinned = 0; i < 6; i++)
+    pinned += fixCounts[i];
+  free(fixCounts);
+  ASSERT_EQUALS_INT(1, pinned, "failed batch released its pins");
+
+  // pages past the end of the file are added to it
+  TEST_CHECK(pinPages(bm, pages, pastEnd, 2));
+  ASSERT_EQUALS_INT(0, pages[0].data[0], "new page is empty");
+  TEST_CHECK(unpinPages(bm, pages, 2));
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// shared state of the page latch test
+typedef struct LatchWorker
+{
+  BM_BufferPool *bm;
+  bool writer;
+  int errors;
+} LatchWorker;
+
+// writers bump two counters on page 0 under the exclusive latch, readers
+// check under the shared latch that they are always equal
+static void *latchWorker(void *arg)
+{
+  LatchWorker *worker = (LatchWorker *)arg;
+  BM_PageHandle h;
+  int i;
+
+  if (pinPage(worker->bm, &h, 0) != RC_OK)
+  {
+    worker->errors++;
+    return NULL;
+  }
+  for (i = 0; i < PINS_PER_THREAD / 4; i++)
+  {
+    volatile int *counters = (volatile int *)h.data;
+    if (worker->writer)
+    {
+      latchPageExclusive(worker->bm, &h);
+      counters[0]++;
+      counters[1] = counters[0];
+    }
+    else
+    {
+      latchPageShared(worker->bm, &h);
+      if (counters[0] != counters[1])
+        worker->errors++;
+    }
+    if (unlatchPage(worker->bm, &h) != RC_OK)
+      worker->errors++;
+  }
+  if (worker->writer)
+    markDirty(worker->bm, &h);
+  unpinPage(worker->bm, &h);
+  return NULL;
+}
+
+// shared and exclusive content latches on pinned pages
+void testPageLatches(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  pthread_t threads[NUM_THREADS];
+  LatchWorker workers[NUM_THREADS];
+  int i, errors = 0;
+  testName = "Testing page content latches";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_LRU, NULL));
+
+  TEST_CHECK(pinPage(bm, h, 0));
+  memset(h->data, 0, 2 * sizeof(int));
+  TEST_CHECK(latchPageShared(bm, h));
+  TEST_CHECK(latchPageShared(bm, h));
+  TEST_CHECK(unlatchPage(bm, h));
+  TEST_CHECK(unlatchPage(bm, h));
+  ASSERT_ERROR(unlatchPage(bm, h), "page is not latched");
+  TEST_CHECK(latchPageExclusive(bm, h));
+  TEST_CHECK(unlatchPage(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_ERROR(latchPageShared(bm, h), "page is not pinned");
+
+  for (i = 0; i < NUM_THREADS; i++)
+  {
+    workers[i].bm = bm;
+    workers[i].writer = (i % 2 == 0);
+    workers[i].errors = 0;
+    pthread_create(&threads[i], NULL, latchWorker, &workers[i]);
+  }
+  for (i = 0; i < NUM_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    errors += workers[i].errors;
+  }
+  ASSERT_EQUALS_INT(0, errors, "readers never saw a half-written page");
+
+  TEST_CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_INT(NUM_THREADS / 2 * (PINS_PER_THREAD / 4), ((int *)h->data)[0], "no update lost");
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// readers copy the two counters of page 0 optimistically while the
+// latchWorker writers bump them, and check that the copies are consistent
+static void *optimisticWorker(void *arg)
+{
+  LatchWorker *worker = (LatchWorker *)arg;
+  BM_PageHandle h;
+  int counters[2];
+  int i;
+
+  h.data = NULL;
+  for (i = 0; i < PINS_PER_THREAD / 4; i++)
+  {
+    if (readPageOptimistic(worker->bm, &h, 0, 0, sizeof(counters), (char *)counters) != RC_OK)
+      worker->errors++;
+    else if (counters[0] != counters[1])
+      worker->errors++;
+  }
+  return NULL;
+}
+
+// optimistic reads validated by the frame version
+void testOptimisticReads(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *hint = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  pthread_t threads[NUM_THREADS];
+  LatchWorker workers[NUM_THREADS];
+  char buf[16];
+  int i, errors = 0;
+  long hits;
+  testName = "Testing optimistic page reads";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 5);
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+
+  // the first read pins the page, the second one is served from the hint
+  hint->data = NULL;
+  TEST_CHECK(readPageOptimistic(bm, hint, 1, 0, 7, buf));
+  buf[7] = '\0';
+  ASSERT_EQUALS_STRING("Page-1", buf, "first read loads the page");
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "one page read");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  hits = stats.hits;
+  TEST_CHECK(readPageOptimistic(bm, hint, 1, 2, 4, buf));
+  ASSERT_TRUE(memcmp(buf, "ge-1", 4) == 0, "second read copies the requested range");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_TRUE(stats.hits == hits, "second read does not pin");
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "second read does no I/O");
+  ASSERT_ERROR(readPageOptimistic(bm, hint, 1, PAGE_SIZE - 2, 4, buf), "range outside the page");
+
+  // evict page 1: the stale hint falls back to pinning
+  for (i = 2; i < 5; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(readPageOptimistic(bm, hint, 1, 0, 7, buf));
+  ASSERT_EQUALS_STRING("Page-1", buf, "stale hint rereads the page");
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "page read again");
+
+  // writers under the exclusive latch, optimistic readers
+  TEST_CHECK(pinPage(bm, h, 0));
+  memset(h->data, 0, 2 * sizeof(int));
+  TEST_CHECK(unpinPage(bm, h));
+  for (i = 0; i < NUM_THREADS; i++)
+  {
+    workers[i].bm = bm;
+    workers[i].writer = (i % 2 == 0);
+    workers[i].errors = 0;
+    pthread_create(&threads[i], NULL, workers[i].writer ? latchWorker : optimisticWorker, &workers[i]);
+  }
+  for (i = 0; i < NUM_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    errors += workers[i].errors;
+  }
+  ASSERT_EQUALS_INT(0, errors, "optimistic readers never saw a half-written page");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  free(hint);
+  TEST_DONE();
+}
+
+// counts the empty frames of a pool
+static int countFreeFrames(BM_BufferPool *bm)
+{
+  PageNumber *pages = getFrameContents(bm);
+  int i, numFree = 0;
+
+  for (i = 0; i < bm->numPages; i++)
+    if (pages[i] == NO_PAGE)
+      numFree++;
+  free(pages);
+  return numFree;
+}
+
+// misses take frames off the free list the evictor refills in batches
+void testEvictor(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_BufferPool file;
+  char expected[64];
+  int *fixCounts;
+  int i, wait;
+  testName = "Testing the free-frame evictor";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 6, RS_LRU, NULL));
+  ASSERT_ERROR(startEvictor(bm, 0, 2), "low watermark must be positive");
+  ASSERT_ERROR(startEvictor(bm, 3, 2), "high watermark below the low watermark");
+  ASSERT_ERROR(startEvictor(bm, 2, 6), "high watermark must leave frames for pages");
+
+  // fill the pool with dirty pages
+  for (i = 0; i < 6; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(h->data, "%s-%i", "Page", i);
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(startEvictor(bm, 2, 4));
+  ASSERT_ERROR(startEvictor(bm, 2, 4), "evictor already running");
+
+  // the first miss evicts inline and wakes the evictor
+  TEST_CHECK(pinPage(bm, h, 6));
+  sprintf(h->data, "%s-%i", "Page", 6);
+  TEST_CHECK(markDirty(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(1, getNumForegroundWriteIO(bm), "victim written on the miss path");
+
+  // wait until the evictor has freed frames up to the high watermark
+  for (wait = 0; wait < 5000 && countFreeFrames(bm) < 4; wait++)
+  {
+    struct timespec ms = {0, 1000000};
+    nanosleep(&ms, NULL);
+  }
+  ASSERT_EQUALS_POOL("[6x0],[-1 0],[-1 0],[-1 0],[-1 0],[5x0]", bm, "least recently used pages evicted in one batch");
+  ASSERT_EQUALS_INT(4, getNumBackgroundWriteIO(bm), "evictor wrote the dirty victims");
+
+  // the next misses pop free frames
+  for (i = 7; i < 11; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(h->data, "%s-%i", "Page", i);
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(1, getNumForegroundWriteIO(bm), "no victim written on the miss path");
+
+  TEST_CHECK(stopEvictor(bm));
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  // every page reached the disk
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+  for (i = 0; i < 11; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "page content");
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  // seen through the handle of the whole pool, the frames on the free
+  // list are empty rather than pinned
+  TEST_CHECK(initSharedBufferPool(bm, 6, RS_LRU, NULL));
+  TEST_CHECK(attachBufferPool(&file, bm, NULL));
+  for (i = 0; i < 6; i++)
+  {
+    TEST_CHECK(pinPage(&file, h, i));
+    TEST_CHECK(unpinPage(&file, h));
+  }
+  TEST_CHECK(startEvictor(bm, 2, 4));
+  TEST_CHECK(pinPage(&file, h, 6));
+  TEST_CHECK(unpinPage(&file, h));
+  for (wait = 0; wait < 5000 && countFreeFrames(bm) < 4; wait++)
+  {
+    struct timespec ms = {0, 1000000};
+    nanosleep(&ms, NULL);
+  }
+  fixCounts = getFixCounts(bm);
+  for (i = 0; i < bm->numPages; i++)
+    ASSERT_EQUALS_INT(0, fixCounts[i], "no fix on a free frame");
+  free(fixCounts);
+  TEST_CHECK(stopEvictor(bm));
+  TEST_CHECK(shutdownBufferPool(&file));
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// hot pages survive a scan, cold pages are evicted first
+void testPageHints(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  int i;
+  testName = "Testing page replacement hints";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 20);
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_LRU, NULL));
+
+  // the header page stays resident while pages are scanned
+  TEST_CHECK(pinPage(bm, h, 0));
+  TEST_CHECK(setPageHint(bm, 0, BM_HINT_HOT));
+  TEST_CHECK(unpinPage(bm, h));
+  for (i = 1; i < 11; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[9 0],[10 0]", bm, "hot page survived the scan");
+
+  // a cold page goes before the least recently used one
+  TEST_CHECK(setPageHint(bm, 10, BM_HINT_COLD));
+  TEST_CHECK(pinPage(bm, h, 11));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[0 0],[9 0],[11 0]", bm, "cold page evicted first");
+  ASSERT_ERROR(setPageHint(bm, 10, BM_HINT_HOT), "hinted page must be resident");
+  ASSERT_ERROR(setPageHint(bm, 0, (BM_PageHint)7), "unknown hint");
+
+  // cleared hints give the strategy its way back
+  TEST_CHECK(setPageHint(bm, 0, BM_HINT_NONE));
+  TEST_CHECK(pinPage(bm, h, 12));
+  TEST_CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[12 0],[9 0],[11 0]", bm, "unhinted header page evicted");
+
+  // a hot page is still evicted when every other page is pinned
+  TEST_CHECK(setPageHint(bm, 11, BM_HINT_HOT));
+  TEST_CHECK(pinPage(bm, h, 12));
+  TEST_CHECK(pinPage(bm, h2, 9));
+  TEST_CHECK(pinPage(bm, h, 13));
+  ASSERT_EQUALS_POOL("[12 1],[9 1],[13 1]", bm, "hot page evicted as the last resort");
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(unpinPage(bm, h2));
+  h->pageNum = 12;
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  free(h2);
+  TEST_DONE();
+}
+
+// dirties a page through a pin
+static void dirtyPage(BM_BufferPool *bm, PageNumber pageNum)
+{
+  BM_PageHandle h;
+
+  TEST_CHECK(pinPage(bm, &h, pageNum));
+  sprintf(h.data, "%s-%i", "Dirty", pageNum);
+  TEST_CHECK(markDirty(bm, &h));
+  TEST_CHECK(unpinPage(bm, &h));
+}
+
+// bumps two counters on each of the pages 0 to 7 under the exclusive
+// latch, with a pause between them, until told to stop
+static void *checkpointWriter(void *arg)
+{
+  int *stop = (int *)arg;
+  BM_PageHandle h;
+  PageNumber p;
+  int k;
+
+  while (!__atomic_load_n(stop, __ATOMIC_RELAXED))
+  {
+    for (p = 0; p < 8; p++)
+    {
+      pinPage(checkpointPool, &h, p);
+      latchPageExclusive(checkpointPool, &h);
+      volatile int *counters = (volatile int *)h.data;
+      counters[0]++;
+      for (k = 0; k < 1000; k++)
+        counters[2] = k;
+      counters[1] = counters[0];
+      markDirty(checkpointPool, &h);
+      unlatchPage(checkpointPool, &h);
+      unpinPage(checkpointPool, &h);
+    }
+  }
+  return NULL;
+}
+
+// fuzzy checkpoints write the dirty-page table in the background
+void testCheckpoint(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  PageNumber *pages;
+  bool *dirty;
+  pthread_t threads[NUM_THREADS / 2];
+  int stop;
+  long checkpointWrites;
+  SM_FileHandle fh;
+  char page[PAGE_SIZE];
+  int i;
+  testName = "Testing fuzzy checkpoints";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 10);
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 10, RS_LRU, NULL));
+  ASSERT_ERROR(startCheckpoint(bm, -1), "negative rate");
+  TEST_CHECK(waitCheckpoint(bm));
+
+  // an unthrottled checkpoint writes every dirty page
+  for (i = 0; i < 8; i++)
+    dirtyPage(bm, i);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_TRUE(stats.oldestDirtyMicros > 0, "dirty pages wait for a write");
+  TEST_CHECK(startCheckpoint(bm, 0));
+  TEST_CHECK(waitCheckpoint(bm));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int)stats.checkpoints, "checkpoint completed");
+  ASSERT_EQUALS_INT(8, (int)stats.checkpointWrites, "every dirty page written");
+  ASSERT_EQUALS_INT(0, (int)stats.checkpointPending, "nothing pending");
+  ASSERT_EQUALS_INT(0, (int)stats.oldestDirtyMicros, "no dirty page left");
+  ASSERT_EQUALS_INT(8, getNumWriteIO(bm), "one write per page");
+
+  // a paced checkpoint runs while pages are pinned and modified
+  for (i = 0; i < 4; i++)
+    dirtyPage(bm, i);
+  TEST_CHECK(startCheckpoint(bm, 20));
+  ASSERT_ERROR(startCheckpoint(bm, 0), "checkpoint already running");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_TRUE(stats.checkpointPending >= 3, "checkpoint in progress");
+
+  // page 3 is written and dirtied again: its old changes are on disk
+  TEST_CHECK(pinPage(bm, h, 3));
+  TEST_CHECK(forcePage(bm, h));
+  TEST_CHECK(markDirty(bm, h));
+  TEST_CHECK(unpinPage(bm, h));
+  dirtyPage(bm, 9);
+
+  TEST_CHECK(waitCheckpoint(bm));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int)stats.checkpoints, "second checkpoint completed");
+  ASSERT_EQUALS_INT(11, (int)stats.checkpointWrites, "redirtied page skipped");
+  ASSERT_TRUE(stats.lastCheckpointMicros >= 100000, "checkpoint paced");
+  pages = getFrameContents(bm);
+  dirty = getDirtyFlags(bm);
+  for (i = 0; i < bm->numPages; i++)
+  {
+    if (pages[i] == 3 || pages[i] == 9)
+      ASSERT_TRUE(dirty[i], "page dirtied after the start stays dirty");
+    else
+      ASSERT_TRUE(!dirty[i], "page dirty at the start written");
+  }
+  free(pages);
+  free(dirty);
+
+  // writers under the exclusive latch never get a half-written page onto
+  // disk through a paced checkpoint
+  for (i = 0; i < 8; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    memset(h->data, 0, 3 * sizeof(int));
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(forceFlushPool(bm));
+  for (i = 0; i < 8; i++)
+  {
+    TEST_CHECK(pinPage(bm, h, i));
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+  }
+  TEST_CHECK(getPoolStats(bm, &stats));
+  checkpointWrites = stats.checkpointWrites;
+  checkpointPool = bm;
+  __atomic_store_n(&stop, 0, __ATOMIC_RELAXED);
+  for (i = 0; i < NUM_THREADS / 2; i++)
+    pthread_create(&threads[i], NULL, checkpointWriter, &stop);
+  TEST_CHECK(startCheckpoint(bm, 100));
+  TEST_CHECK(waitCheckpoint(bm));
+  __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+  for (i = 0; i < NUM_THREADS / 2; i++)
+    pthread_join(threads[i], NULL);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(8, (int)(stats.checkpointWrites - checkpointWrites), "checkpoint wrote the pages under change");
+  TEST_CHECK(openPageFile(TEST_FILE, &fh));
+  for (i = 0; i < 8; i++)
+  {
+    TEST_CHECK(readBlock(i, &fh, page));
+    ASSERT_EQUALS_INT(((int *)page)[0], ((int *)page)[1], "consistent page on disk");
+  }
+  TEST_CHECK(closePageFile(&fh));
+
+  // shutting down stops a running checkpoint and writes the rest itself
+  TEST_CHECK(startCheckpoint(bm, 1));
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(initBufferPool(bm, TEST_FILE, 3, RS_FIFO, NULL));
+  TEST_CHECK(pinPage(bm, h, 9));
+  ASSERT_EQUALS_STRING("Dirty-9", h->data, "page written on shutdown");
+  TEST_CHECK(unpinPage(bm, h));
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// frames backed by huge pages, or by normal pages where none are available
+void testHugePages(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {false, false, NULL, BM_HUGE_PAGES_NONE};
+  BM_PoolStats stats;
+  BM_HugePages modes[] = {BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT};
+  char expected[64];
+  int m, i;
+  testName = "Testing huge page backed frames";
+
+  TEST_CHECK(createPageFile(TEST_FILE));
+  createDummyPages(bm, 30);
+
+  TEST_CHECK(initBufferPoolWithOptions(bm, TEST_FILE, 8, RS_CLOCK, NULL, &options));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int)stats.hugePageFrames, "normal pages by default");
+  TEST_CHECK(shutdownBufferPool(bm));
+
+  for (m = 0; m < 2; m++)
+  {
+    options.hugePages = modes[m];
+    TEST_CHECK(initBufferPoolWithOptions(bm, TEST_FILE, 8, RS_CLOCK, NULL, &options));
+    TEST_CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(stats.hugePageFrames == 0 || stats.hugePageFrames == 8, "every frame backed alike");
+
+    // shrinking and growing again keeps the pages intact
+    TEST_CHECK(resizeBufferPool(bm, 4));
+    TEST_CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(stats.hugePageFrames == 0 || stats.hugePageFrames == 4, "retired frames not counted");
+    TEST_CHECK(resizeBufferPool(bm, 12));
+    TEST_CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(stats.hugePageFrames == 0 || stats.hugePageFrames == 12, "added frames counted");
+    for (i = 0; i < 30; i++)
+    {
+      TEST_CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page content");
+      TEST_CHECK(unpinPage(bm, h));
+    }
+    TEST_CHECK(shutdownBufferPool(bm));
+  }
+  TEST_CHECK(destroyPageFile(TEST_FILE));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
@@ -31,6 +31,7 @@
 static void testValueSerialize(void);
 static void testOperators(void);
 static void testExpressions(void);
+static void testNullLogic(void);
 
 char *testName;
 
@@ -42,6 +43,7 @@ int main(void)
   testValueSerialize();
   testOperators();
   testExpressions();
+  testNullLogic();
 
   return 0;
 }
@@ -121,3 +123,35 @@ void testExpressions(void)
 
   TEST_DONE();
 }
+
+// ************************************************************
+void testNullLogic(void)
+{
+  Value *null, *result;
+  testName = "test three-valued logic with NULL values";
+  MAKE_NULL_VALUE(null);
+  MAKE_VALUE(result, DT_INT, 0);
+
+  ASSERT_EQUALS_STRING("NULL", serializeValue(null), "serialize NULL");
+  TEST_CHECK(valueEquals(null, stringToValue("i10"), result));
+  ASSERT_TRUE(IS_NULL(result), "NULL = 10 is NULL");
+  TEST_CHECK(valueSmaller(stringToValue("i10"), null, result));
+  ASSERT_TRUE(IS_NULL(result), "10 < NULL is NULL");
+  TEST_CHECK(boolNot(null, result));
+  ASSERT_TRUE(IS_NULL(result), "NOT NULL is NULL");
+
+  TEST_CHECK(boolAnd(stringToValue("bf"), null, result));
+  ASSERT_TRUE(result->dt == DT_BOOL && !result->v.boolV, "f AND NULL = f");
+  TEST_CHECK(boolAnd(null, stringToValue("bt"), result));
+  ASSERT_TRUE(IS_NULL(result), "NULL AND t is NULL");
+  TEST_CHECK(boolOr(null, stringToValue("bt"), result));
+  ASSERT_TRUE(result->dt == DT_BOOL && result->v.boolV, "NULL OR t = t");
+  TEST_CHECK(boolOr(stringToValue("bf"), null, result));
+  ASSERT_TRUE(IS_NULL(result), "f OR NULL is NULL");
+  TEST_CHECK(boolAnd(stringToValue("bt"), stringToValue("bt"), result));
+  ASSERT_TRUE(result->dt == DT_BOOL && result->v.boolV, "t AND t is a boolean");
+
+  freeVal(null);
+  freeVal(result);
+  TEST_DONE();
+}